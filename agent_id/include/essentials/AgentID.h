@@ -1,66 +1,123 @@
 #pragma once
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <stdint.h>
+#include <type_traits>
 #include <vector>
 
 namespace essentials
 {
 
+/**
+ * An ID of up to MAX_SIZE bytes, which are stored inline together with their size and a type tag.
+ * AgentIDs are trivially copyable values, so copying, comparing and hashing them never allocates.
+ *
+ * Broadcast IDs carry the type tag BC_TYPE and no bytes. They are only equal to each other and sort before all other IDs.
+ *
+ * IDs interned by an AgentIDManager or SharedAgentIDRegistry carry a dense handle, which is
+ * unique within that manager and kept by copies. It is not part of the ID's value, so equality and ordering ignore it.
+ */
 class AgentID
 {
-    friend struct std::hash<essentials::AgentID>;
+    friend class AgentIDManager;
+    friend class SharedAgentIDRegistry;
 
 public:
+    static const int MAX_SIZE = 32;
+    static const uint32_t NO_HANDLE = 0xffffffff;
+
+    static const uint8_t INT_TYPE = 0;
+    static const uint8_t BC_TYPE = 1;
+    static const uint8_t UUID_TYPE = 2;
+
+    AgentID();
     AgentID(const uint8_t* idBytes, int idSize, uint8_t type = UUID_TYPE);
-    virtual ~AgentID();
-    virtual bool operator==(const AgentID& obj) const;
-    virtual bool operator!=(const AgentID& obj) const;
-    virtual bool operator<(const AgentID& other) const;
-    virtual bool operator>(const AgentID& other) const;
-    virtual const uint8_t* getRaw() const;
-    virtual int getSize() const;
-    virtual std::vector<uint8_t> toByteVector() const;
-    virtual std::size_t hash() const;
-    virtual uint8_t getType() const;
+
+    static AgentID broadcast() { return AgentID(nullptr, 0, BC_TYPE); }
+
+    bool isBroadcast() const { return this->type == BC_TYPE; }
+
+    bool operator==(const AgentID& other) const
+    {
+        // bytes beyond the size are zero, so comparing the whole buffers would be correct, too
+        return this->size == other.size && this->isBroadcast() == other.isBroadcast() && memcmp(this->id, other.id, this->size) == 0;
+    }
+
+    bool operator!=(const AgentID& other) const { return !(*this == other); }
+
+    /**
+     * Orders broadcast IDs first, then shorter IDs before longer ones and IDs of equal size by their bytes.
+     */
+    bool operator<(const AgentID& other) const
+    {
+        if (this->isBroadcast() != other.isBroadcast()) {
+            return this->isBroadcast();
+        }
+        if (this->size != other.size) {
+            return this->size < other.size;
+        }
+        return memcmp(this->id, other.id, this->size) < 0;
+    }
+
+    bool operator>(const AgentID& other) const { return other < *this; }
+
+    const uint8_t* getRaw() const { return this->id; }
+    int getSize() const { return this->size; }
+    uint8_t getType() const { return this->type; }
+    uint32_t getHandle() const { return this->handle; }
+    std::vector<uint8_t> toByteVector() const { return std::vector<uint8_t>(this->id, this->id + this->size); }
+    std::size_t hash() const { return this->hashValue; }
+    static std::size_t hash(const uint8_t* bytes, int size);
 
     friend std::ostream& operator<<(std::ostream& os, const essentials::AgentID& obj)
     {
-        if (obj.id.size() <= sizeof(int)) {
-            std::vector<uint8_t> tmpLong;
-            for (int i = 0; i < static_cast<int>(obj.id.size()); i++) {
-                tmpLong.push_back(obj.id[i]);
-            }
-            for (int i = 0; i < static_cast<int>(sizeof(int) - obj.id.size()); i++) {
-                tmpLong.push_back(0);
-            }
-            os << (int) (*tmpLong.data());
+        if (obj.isBroadcast()) {
+            os << "BroadcastID (0)";
+        } else if (obj.size <= sizeof(int)) {
+            // little-endian encoding, like AgentIDManager::getID
+            int value = 0;
+            memcpy(&value, obj.id, obj.size);
+            os << value;
         } else {
-            std::vector<uint8_t> tmpShort;
-            tmpShort.push_back(obj.id[0]);
-            tmpShort.push_back(obj.id[1]);
-            os << (short) (*tmpShort.data()) << "[...]";
-            tmpShort.clear();
-            tmpShort.push_back(obj.id[obj.id.size() - 2]);
-            tmpShort.push_back(obj.id[obj.id.size() - 1]);
-            os << (short) (*tmpShort.data());
+            short front, back;
+            memcpy(&front, obj.id, sizeof(short));
+            memcpy(&back, obj.id + obj.size - sizeof(short), sizeof(short));
+            os << front << "[...]" << back;
         }
         return os;
     }
 
-    const uint8_t TYPE;
-
-    static const uint8_t INT_TYPE = 0;
-    static const uint8_t BC_TYPE = 1;
-    static const uint8_t UUID_TYPE = 2;
-
 private:
-    std::vector<uint8_t> id;
+    uint8_t id[MAX_SIZE]; /**< Zero beyond size */
+    uint8_t size;
+    uint8_t type;
+    uint32_t handle; /**< Index assigned by the interning AgentIDManager or NO_HANDLE */
+    std::size_t hashValue; /**< Computed once at construction, 0 for broadcast IDs */
 };
 
+static_assert(std::is_trivially_copyable<AgentID>::value, "AgentID must stay a trivially copyable value");
+
 struct AgentIDComparator
 {
     bool operator()(const AgentID* a, const AgentID* b) const { return *a < *b; }
 };
 
+/**
+ * Orders IDs interned by the same AgentIDManager by their handles, i.e., by integer compares.
+ * IDs without a handle are compared by value.
+ */
+struct AgentIDHandleComparator
+{
+    bool operator()(const AgentID* a, const AgentID* b) const
+    {
+        if (a->getHandle() != b->getHandle()) {
+            return a->getHandle() < b->getHandle();
+        }
+        return a->getHandle() == AgentID::NO_HANDLE && *a < *b;
+    }
+};
+
 struct AgentIDEqualsComparator
 {
     bool operator()(const AgentID* const a, const AgentID* b) const { return *a == *b; }
@@ -72,3 +129,12 @@ struct AgentIDHash
 };
 
 } /* namespace essentials */
+
+namespace std
+{
+template <>
+struct hash<essentials::AgentID>
+{
+    std::size_t operator()(const essentials::AgentID& id) const { return id.hash(); }
+};
+} // namespace std
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "AgentID.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace essentials
+{
+
+class AgentIDManager;
+
+/**
+ * Compact wire format for lists of AgentIDs, e.g., the robots of a team-wide command.
+ *
+ * The list starts with the number of IDs, followed by one varint tag per ID:
+ * - odd tags repeat the ID at position tag >> 1, so each distinct ID is only sent once
+ * - even tags start a new ID of type tag >> 3 and the form (tag >> 1) & 3, which is
+ *   raw (a varint size and the bytes), int (4 byte IDs as zigzag varint) or broadcast (no payload)
+ *
+ * Decoding writes into the caller's vector and needs no further allocations. Decoding with an
+ * AgentIDManager keeps the type of the interned ID instead of the one on the wire.
+ */
+class AgentIDCodec
+{
+public:
+    static void encode(const std::vector<const AgentID*>& ids, std::vector<uint8_t>& out);
+    static void encode(const AgentID* const* ids, size_t count, std::vector<uint8_t>& out);
+
+    static void decode(const std::vector<uint8_t>& data, std::vector<AgentID>& ids);
+    static void decode(const uint8_t* data, size_t size, std::vector<AgentID>& ids);
+    static void decode(const uint8_t* data, size_t size, AgentIDManager* manager, std::vector<const AgentID*>& ids);
+
+private:
+    static const uint64_t REPEAT = 1;
+    static const uint64_t RAW = 0;
+    static const uint64_t INT = 1;
+    static const uint64_t BROADCAST = 2;
+
+    class Reader;
+
+    static void writeVarint(uint64_t value, std::vector<uint8_t>& out);
+    static AgentID readID(Reader& reader, uint64_t tag);
+};
+
+} /* namespace essentials */
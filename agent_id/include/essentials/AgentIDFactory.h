@@ -2,16 +2,40 @@
 
 #include "AgentID.h"
 
+#include <mutex>
+#include <random>
+
 namespace essentials
 {
 
+/**
+ * Creates IDs and generates random ones from a pool of random bytes, which is refilled in bulk,
+ * so generating an ID needs no syscall. By default, the pool is filled by getrandom or from
+ * /dev/urandom on kernels without it. A factory constructed with a seed fills its pool from a
+ * deterministic generator instead, so simulations can reproduce their IDs.
+ */
 class AgentIDFactory
 {
 public:
     AgentIDFactory();
+    explicit AgentIDFactory(uint64_t seed);
     virtual ~AgentIDFactory();
     virtual const AgentID* create(const std::vector<uint8_t>& bytes) const;
+    virtual const AgentID* create(const uint8_t* bytes, size_t size) const;
     virtual const AgentID* generateID(int size = 16) const;
+    void generateBytes(uint8_t* bytes, int size) const;
+    bool isDeterministic() const { return this->deterministic; }
+
+private:
+    static const int POOL_SIZE = 4096;
+
+    void refill() const;
+
+    bool deterministic;
+    mutable std::mt19937_64 random; /**< Only used in deterministic mode */
+    mutable std::mutex mutex;
+    mutable uint8_t pool[POOL_SIZE];
+    mutable int poolPosition; /**< Bytes before it are used up */
 };
 
 } /* namespace essentials */
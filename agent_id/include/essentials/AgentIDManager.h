@@ -3,31 +3,163 @@
 #include "essentials/AgentID.h"
 #include "essentials/AgentIDFactory.h"
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <unordered_set>
 #include <vector>
 
 namespace essentials
 {
 
+class AgentIDManager;
+class SharedAgentIDRegistry;
+
+/**
+ * A counted reference to an ID interned by an AgentIDManager, which keeps the ID alive while the
+ * reference or one of its copies exists.
+ */
+class AgentIDRef
+{
+public:
+    AgentIDRef();
+    AgentIDRef(const AgentIDRef& other);
+    AgentIDRef(AgentIDRef&& other);
+    AgentIDRef& operator=(AgentIDRef other);
+    ~AgentIDRef();
+
+    const AgentID* get() const { return this->id; }
+    const AgentID* operator->() const { return this->id; }
+    const AgentID& operator*() const { return *this->id; }
+    explicit operator bool() const { return this->id != nullptr; }
+
+private:
+    friend class AgentIDManager;
+    AgentIDRef(AgentIDManager* manager, const AgentID* id);
+
+    AgentIDManager* manager;
+    const AgentID* id;
+};
+
+/**
+ * Interns AgentIDs, so each ID exists once and gets a dense handle.
+ *
+ * By default, interned IDs live as long as the manager. A manager constructed with reclaimUnusedIDs
+ * frees IDs, which are only held by AgentIDRefs, after their last reference is gone. The freed
+ * memory and handle are reused once no lock-free lookup, which started before the removal, can
+ * still see the ID (epoch-based reclamation). IDs returned as plain pointers stay pinned forever.
+ *
+ * A manager constructed with a SharedAgentIDRegistry interns all IDs in that registry instead, so
+ * they and their handles are shared by all processes of the host. Such IDs are never freed. The
+ * capacity of the registry is fixed, when its segment is created. Once it is full, further IDs are
+ * interned by this manager alone, with handles from the capacity upwards, which other processes do not share.
+ */
 class AgentIDManager
 {
 public:
     // static AgentIDManager *getInstance();
-    AgentIDManager(AgentIDFactory* idFactory);
+    AgentIDManager(AgentIDFactory* idFactory, bool reclaimUnusedIDs = false);
+    AgentIDManager(AgentIDFactory* idFactory, SharedAgentIDRegistry* sharedRegistry);
     virtual ~AgentIDManager();
 
     const AgentID* getIDFromBytes(const std::vector<uint8_t>& vectorID);
+    const AgentID* getIDFromBytes(const uint8_t* idBytes, size_t idSize);
+    const AgentID* findIDFromBytes(const uint8_t* idBytes, size_t idSize);
 
     template <class Prototype>
     const AgentID* getID(Prototype& idPrototype);
 
     const AgentID* generateID(int size = 16);
 
+    AgentIDRef acquireIDFromBytes(const std::vector<uint8_t>& vectorID);
+    AgentIDRef acquireIDFromBytes(const uint8_t* idBytes, size_t idSize);
+
+    template <class Prototype>
+    AgentIDRef acquireID(Prototype& idPrototype);
+
+    const AgentID* getIDFromHandle(uint32_t handle) const;
+    uint32_t getIDCount() const;
+
 private:
-    std::unordered_set<const AgentID*, essentials::AgentIDHash, essentials::AgentIDEqualsComparator> agentIDs;
+    friend class AgentIDRef;
+
+    static const uint32_t CHUNK_SIZE = 1024;
+    static const uint32_t MAX_CHUNKS = 4096;
+    static const uint32_t PINNED = 0x80000000; /**< Reference count bit of IDs, which are never freed */
+    static const int READER_SHARDS = 32;
+
+    /**
+     * Open addressing hash table with linear probing. Readers probe without locking, so a removed
+     * ID leaves a tombstone behind. A table full of IDs and tombstones is replaced by a fresh copy.
+     */
+    struct Table
+    {
+        Table(size_t capacity);
+        size_t mask;
+        size_t size;
+        size_t tombstones;
+        std::unique_ptr<std::atomic<const AgentID*>[]> slots;
+    };
+
+    /**
+     * Number of lock-free lookups in progress per parity of the epoch they started in. Threads share
+     * the shards by the hash of their thread id, the padding keeps the shards on separate cache lines.
+     */
+    struct ReaderShard
+    {
+        std::atomic<uint32_t> count[2];
+        char padding[64 - 2 * sizeof(std::atomic<uint32_t>)];
+    };
+
+    /**
+     * Announces a lock-free lookup, which may see IDs and tables removed during it, for as long as it lives.
+     */
+    class ReadGuard
+    {
+    public:
+        ReadGuard(AgentIDManager* manager);
+        ~ReadGuard();
+
+    private:
+        std::atomic<uint32_t>* count;
+    };
+
+    /**
+     * A removed ID or replaced table, which is freed once the epoch has advanced twice.
+     */
+    struct Retired
+    {
+        uint64_t epoch;
+        std::unique_ptr<const AgentID> id;
+        std::unique_ptr<Table> table;
+    };
+
+    std::atomic<Table*> table;                /**< The current table, which is probed without locking */
+    std::vector<std::unique_ptr<Table>> tables; /**< Owns the tables, which are kept unless unused IDs are reclaimed */
+    std::unique_ptr<std::atomic<const AgentID*>[]> handleChunks[MAX_CHUNKS]; /**< IDs by handle, allocated in chunks that never move */
+    std::unique_ptr<std::atomic<uint32_t>[]> refChunks[MAX_CHUNKS]; /**< Reference counts by handle */
+    std::atomic<uint32_t> idCount; /**< Number of handles ever assigned */
+    std::vector<uint32_t> freeHandles;
     AgentIDFactory* idFactory;
-    std::mutex mutex;
+    std::mutex mutex; /**< Serialises inserts and removals */
+    bool reclaimUnusedIDs;
+    std::atomic<uint64_t> epoch;
+    ReaderShard readers[READER_SHARDS];
+    std::deque<Retired> retired; /**< Ordered by epoch */
+    std::unique_ptr<SharedAgentIDRegistry> sharedRegistry;
+    uint32_t handleOffset; /**< First handle of IDs interned by this manager, the capacity of the sharedRegistry */
+    std::atomic<bool> sharedRegistryFull; /**< Set once the registry has refused an ID, later inserts bypass it */
+
+    const AgentID* intern(const uint8_t* idBytes, size_t idSize, bool pin);
+    bool tryAddReference(const AgentID* id, bool pin);
+    void addReference(const AgentID* id);
+    void release(const AgentID* id);
+    void remove(const AgentID* id);
+    void reclaim();
+    std::atomic<uint32_t>& getReferences(uint32_t handle) { return this->refChunks[handle / CHUNK_SIZE][handle % CHUNK_SIZE]; }
+
+    static const AgentID* find(const Table* table, const uint8_t* idBytes, size_t idSize, size_t hash);
+    static void insert(Table* table, const AgentID* id, size_t hash);
 };
 
 /**
@@ -41,12 +173,16 @@ template <class Prototype>
 const AgentID* AgentIDManager::getID(Prototype& idPrototype)
 {
     // little-endian encoding
-    std::vector<uint8_t> idByteVector;
-    // TODO: replace with memcpy or std copy
-    for (int i = 0; i < static_cast<int>(sizeof(Prototype)); i++) {
-        idByteVector.push_back(*(((uint8_t*) &idPrototype) + i));
-    }
-    return this->getIDFromBytes(idByteVector);
+    return this->getIDFromBytes(reinterpret_cast<const uint8_t*>(&idPrototype), sizeof(Prototype));
+}
+
+/**
+ * Like getID, but returns a reference, which keeps the ID alive without pinning it.
+ */
+template <class Prototype>
+AgentIDRef AgentIDManager::acquireID(Prototype& idPrototype)
+{
+    return this->acquireIDFromBytes(reinterpret_cast<const uint8_t*>(&idPrototype), sizeof(Prototype));
 }
 
 } /* namespace essentials */
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AgentID.h"
+
+#include <atomic>
+#include <string>
+
+namespace essentials
+{
+
+/**
+ * Interns AgentIDs in a named POSIX shared memory segment, so all processes of a host, which open
+ * the same name, see the same IDs under the same dense handles. The IDs are stored in the segment
+ * itself and returned as pointers into the local mapping. Lookups probe an open addressing table of
+ * handles without locking, inserts are serialised by a robust, process-shared mutex, which is
+ * recovered when its owner dies.
+ *
+ * The segment is created with mode 0600, so only processes of the creating user can open it. As
+ * the segment is still writable by all of them, its content is not trusted: handles in the table,
+ * which point beyond the IDs, raise std::runtime_error instead of being followed.
+ *
+ * The number of IDs is fixed by the process that creates the segment and getIDFromBytes throws
+ * std::length_error once it is reached. IDs are never removed.
+ */
+class SharedAgentIDRegistry
+{
+public:
+    SharedAgentIDRegistry(const std::string& name, uint32_t maxIDs = 65536);
+    virtual ~SharedAgentIDRegistry();
+
+    const AgentID* getIDFromBytes(const uint8_t* idBytes, size_t idSize);
+    const AgentID* findID(const uint8_t* idBytes, size_t idSize) const;
+    const AgentID* getIDFromHandle(uint32_t handle) const;
+    uint32_t getIDCount() const;
+    uint32_t getMaxIDs() const;
+    const std::string& getName() const { return this->name; }
+
+    static bool remove(const std::string& name);
+
+private:
+    struct Header;
+
+    std::string name;
+    void* segment;
+    size_t segmentSize;
+    Header* header;
+    std::atomic<uint32_t>* slots; /**< Handle + 1 of the ID in each slot, 0 for free slots */
+    AgentID* ids;                 /**< Indexed by handle */
+    uint32_t maxIDs;              /**< Copy of the header's maxIDs, checked against the segment size when mapping */
+    uint32_t mask;                /**< Copy of the header's mask, checked likewise */
+
+    void map(uint32_t maxIDs);
+    void lock();
+    void unlock();
+    void repair();
+    const AgentID* find(const uint8_t* idBytes, size_t idSize, size_t hash) const;
+    void insert(uint32_t handle, size_t hash);
+    uint32_t loadIDCount() const;
+
+    static std::string toSegmentName(const std::string& name);
+};
+
+} /* namespace essentials */
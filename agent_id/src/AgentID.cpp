@@ -1,136 +1,127 @@
 #include "essentials/AgentID.h"
 
+#include <stdexcept>
+#include <string>
+
 namespace essentials
 {
 
-AgentID::AgentID(const uint8_t* idBytes, int idSize, uint8_t type)
-        : TYPE(type)
-{
-    for (int i = 0; i < idSize; i++) {
-        this->id.push_back(idBytes[i]);
-    }
-}
-
-AgentID::~AgentID(){};
+const int AgentID::MAX_SIZE;
+const uint32_t AgentID::NO_HANDLE;
+const uint8_t AgentID::INT_TYPE;
+const uint8_t AgentID::BC_TYPE;
+const uint8_t AgentID::UUID_TYPE;
 
-uint8_t AgentID::getType() const
+AgentID::AgentID()
+        : id()
+        , size(0)
+        , type(UUID_TYPE)
+        , handle(NO_HANDLE)
+        , hashValue(hash(nullptr, 0))
 {
-    return this->TYPE;
 }
 
-bool AgentID::operator==(const AgentID& other) const
+/**
+ * Copies the given bytes. Broadcast IDs ignore them, as all broadcast IDs are equal.
+ * @throws std::length_error, if the ID is longer than MAX_SIZE bytes.
+ */
+AgentID::AgentID(const uint8_t* idBytes, int idSize, uint8_t type)
+        : id()
+        , size(0)
+        , type(type)
+        , handle(NO_HANDLE)
+        , hashValue(0)
 {
-    if (this->id.size() != other.id.size()) {
-        return false;
+    if (idSize > MAX_SIZE) {
+        throw std::length_error("AgentID: " + std::to_string(idSize) + " bytes exceed the maximum of " + std::to_string(MAX_SIZE) + " bytes");
     }
-    for (int i = 0; i < static_cast<int>(this->id.size()); i++) {
-        if (this->id[i] != other.id[i]) {
-            return false;
-        }
+    if (type != BC_TYPE && idSize > 0) {
+        memcpy(this->id, idBytes, idSize);
+        this->size = idSize;
     }
-    return true;
+    this->hashValue = (type == BC_TYPE ? 0 : hash(this->id, this->size));
 }
 
-bool AgentID::operator!=(const AgentID& other) const
+namespace
 {
-    return !(*this == other);
-}
+const uint64_t SECRET[4] = {0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
 
-bool AgentID::operator<(const AgentID& other) const
-{
-    if (this->id.size() < other.id.size()) {
-        return true;
-    } else if (this->id.size() > other.id.size()) {
-        return false;
-    }
-    for (int i = 0; i < this->id.size(); i++) {
-        if (this->id[i] < other.id[i]) {
-            return true;
-        } else if (this->id[i] > other.id[i]) {
-            return false;
-        }
-        // else continue, because both bytes where equal and the next byte needs to be considered
-    }
-    return false;
-}
-
-bool AgentID::operator>(const AgentID& other) const
+/**
+ * Replaces a and b by the low and high half of their 128 bit product.
+ */
+inline void multiply(uint64_t* a, uint64_t* b)
 {
-    if (this->id.size() > other.id.size()) {
-        return true;
-    } else if (this->id.size() < other.id.size()) {
-        return false;
-    }
-    for (int i = 0; i < this->id.size(); i++) {
-        if (this->id[i] > other.id[i]) {
-            return true;
-        } else if (this->id[i] < other.id[i]) {
-            return false;
-        }
-        // else continue, because both bytes where equal and the next byte needs to be considered
-    }
-    return false;
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = *a;
+    r *= *b;
+    *a = static_cast<uint64_t>(r);
+    *b = static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = static_cast<uint32_t>(*a), lb = static_cast<uint32_t>(*b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
 }
 
-const uint8_t* AgentID::getRaw() const
+inline uint64_t mix(uint64_t a, uint64_t b)
 {
-    return this->id.data();
+    multiply(&a, &b);
+    return a ^ b;
 }
 
-int AgentID::getSize() const
+inline uint64_t read8(const uint8_t* p)
 {
-    return this->id.size();
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
 }
 
-std::vector<uint8_t> AgentID::toByteVector() const
+inline uint64_t read4(const uint8_t* p)
 {
-    return this->id;
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
 }
+} // namespace
 
 /**
- * See:
- * https://en.wikipedia.org/wiki/MurmurHash
- * https://softwareengineering.stackexchange.com/questions/49550/which-hashing-algorithm-is-best-for-uniqueness-and-speed
+ * wyhash (final version 4) for inputs of up to 48 bytes, see https://github.com/wangyi-fudan/wyhash.
+ * IDs of 4 to 16 bytes, e.g. ints and UUIDs, are hashed with two overlapping reads and a single
+ * multiplication round. All reads go through memcpy, so unaligned bytes are fine on every target.
  */
-std::size_t AgentID::hash() const
+std::size_t AgentID::hash(const uint8_t* bytes, int size)
 {
-    const uint8_t* key = this->id.data();
-    int len = this->id.size();
-    uint32_t h = 13;
-    if (len > 3) {
-        const uint32_t* key_x4 = (const uint32_t*) key;
-        size_t i = this->id.size() >> 2;
-        do {
-            uint32_t k = *key_x4++;
-            k *= 0xcc9e2d51;
-            k = (k << 15) | (k >> 17);
-            k *= 0x1b873593;
-            h ^= k;
-            h = (h << 13) | (h >> 19);
-            h = (h * 5) + 0xe6546b64;
-        } while (--i);
-        key = (const uint8_t*) key_x4;
-    }
-    if (len & 3) {
-        size_t i = len & 3;
-        uint32_t k = 0;
-        key = &key[i - 1];
-        do {
-            k <<= 8;
-            k |= *key--;
-        } while (--i);
-        k *= 0xcc9e2d51;
-        k = (k << 15) | (k >> 17);
-        k *= 0x1b873593;
-        h ^= k;
+    const uint8_t* p = bytes;
+    size_t len = size;
+    uint64_t seed = mix(SECRET[0], SECRET[1]);
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (read4(p) << 32) | read4(p + ((len >> 3) << 2));
+            b = (read4(p + len - 4) << 32) | read4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        while (i > 16) {
+            seed = mix(read8(p) ^ SECRET[1], read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = read8(p + i - 16);
+        b = read8(p + i - 8);
     }
-    h ^= len;
-    h ^= h >> 16;
-    h *= 0x85ebca6b;
-    h ^= h >> 13;
-    h *= 0xc2b2ae35;
-    h ^= h >> 16;
-    return h;
+    a ^= SECRET[1];
+    b ^= seed;
+    multiply(&a, &b);
+    return static_cast<std::size_t>(mix(a ^ SECRET[0] ^ len, b ^ SECRET[1]));
 }
 
 } /* namespace essentials */
@@ -0,0 +1,212 @@
+#include "essentials/AgentIDCodec.h"
+#include "essentials/AgentIDManager.h"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace essentials
+{
+
+const uint64_t AgentIDCodec::REPEAT;
+const uint64_t AgentIDCodec::RAW;
+const uint64_t AgentIDCodec::INT;
+const uint64_t AgentIDCodec::BROADCAST;
+
+namespace
+{
+/**
+ * AgentID::operator== ignores the type, but IDs of different types must not become repetitions of each other.
+ */
+struct SameIDAndType
+{
+    bool operator()(const AgentID& a, const AgentID& b) const { return a == b && a.getType() == b.getType(); }
+};
+} // namespace
+
+/**
+ * Reads varints and bytes with bounds checks.
+ */
+class AgentIDCodec::Reader
+{
+public:
+    Reader(const uint8_t* data, size_t size)
+            : position(data)
+            , end(data + size)
+    {
+    }
+
+    uint64_t readVarint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (this->position == this->end) {
+                throw std::runtime_error("AgentIDCodec: Truncated varint");
+            }
+            uint8_t byte = *this->position++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("AgentIDCodec: Varint is too long");
+    }
+
+    const uint8_t* readBytes(size_t count)
+    {
+        if (static_cast<size_t>(this->end - this->position) < count) {
+            throw std::runtime_error("AgentIDCodec: Truncated ID");
+        }
+        const uint8_t* bytes = this->position;
+        this->position += count;
+        return bytes;
+    }
+
+    size_t remaining() const { return this->end - this->position; }
+
+private:
+    const uint8_t* position;
+    const uint8_t* end;
+};
+
+void AgentIDCodec::encode(const std::vector<const AgentID*>& ids, std::vector<uint8_t>& out)
+{
+    encode(ids.data(), ids.size(), out);
+}
+
+/**
+ * Appends the given IDs to out.
+ * @throws std::invalid_argument, if one of the IDs is nullptr. Broadcasts are encoded from AgentID::broadcast().
+ */
+void AgentIDCodec::encode(const AgentID* const* ids, size_t count, std::vector<uint8_t>& out)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (ids[i] == nullptr) {
+            throw std::invalid_argument("AgentIDCodec: Cannot encode the null ID at position " + std::to_string(i));
+        }
+    }
+    std::unordered_map<AgentID, uint32_t, std::hash<AgentID>, SameIDAndType> firstPositions(2 * count);
+    writeVarint(count, out);
+    for (size_t i = 0; i < count; i++) {
+        const AgentID& id = *ids[i];
+        auto inserted = firstPositions.emplace(id, i);
+        if (!inserted.second) {
+            writeVarint((static_cast<uint64_t>(inserted.first->second) << 1) | REPEAT, out);
+        } else if (id.isBroadcast()) {
+            writeVarint((static_cast<uint64_t>(id.getType()) << 3) | (BROADCAST << 1), out);
+        } else if (id.getSize() == sizeof(int32_t)) {
+            writeVarint((static_cast<uint64_t>(id.getType()) << 3) | (INT << 1), out);
+            // little-endian, like AgentIDManager::getID, and zigzag, so small negative values stay short
+            uint32_t value = id.getRaw()[0] | (id.getRaw()[1] << 8) | (id.getRaw()[2] << 16) | (static_cast<uint32_t>(id.getRaw()[3]) << 24);
+            writeVarint((value << 1) ^ static_cast<uint32_t>(-static_cast<int32_t>(value >> 31)), out);
+        } else {
+            writeVarint((static_cast<uint64_t>(id.getType()) << 3) | (RAW << 1), out);
+            writeVarint(id.getSize(), out);
+            out.insert(out.end(), id.getRaw(), id.getRaw() + id.getSize());
+        }
+    }
+}
+
+void AgentIDCodec::decode(const std::vector<uint8_t>& data, std::vector<AgentID>& ids)
+{
+    decode(data.data(), data.size(), ids);
+}
+
+/**
+ * Replaces the content of ids by the decoded IDs, which do not carry handles.
+ * @throws std::runtime_error, if the data is truncated or malformed.
+ */
+void AgentIDCodec::decode(const uint8_t* data, size_t size, std::vector<AgentID>& ids)
+{
+    Reader reader(data, size);
+    uint64_t count = reader.readVarint();
+    // every ID takes at least one byte, which bounds the reservation for malformed input
+    if (count > reader.remaining()) {
+        throw std::runtime_error("AgentIDCodec: " + std::to_string(count) + " IDs cannot fit into " + std::to_string(reader.remaining()) + " bytes");
+    }
+    ids.clear();
+    ids.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t tag = reader.readVarint();
+        if (tag & REPEAT) {
+            if ((tag >> 1) >= i) {
+                throw std::runtime_error("AgentIDCodec: Repeated ID refers to a later position");
+            }
+            ids.push_back(ids[tag >> 1]);
+        } else {
+            ids.push_back(readID(reader, tag));
+        }
+    }
+}
+
+/**
+ * Replaces the content of ids by the decoded IDs interned by the given manager, which carry its handles.
+ * Broadcast IDs are not interned and decoded as nullptr.
+ * Attention: The manager interns by bytes only, so the type tags on the wire are dropped and the IDs carry
+ * the type they were first interned with. Decode into AgentIDs, if the types matter.
+ * @throws std::runtime_error, if the data is truncated or malformed.
+ */
+void AgentIDCodec::decode(const uint8_t* data, size_t size, AgentIDManager* manager, std::vector<const AgentID*>& ids)
+{
+    Reader reader(data, size);
+    uint64_t count = reader.readVarint();
+    if (count > reader.remaining()) {
+        throw std::runtime_error("AgentIDCodec: " + std::to_string(count) + " IDs cannot fit into " + std::to_string(reader.remaining()) + " bytes");
+    }
+    ids.clear();
+    ids.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t tag = reader.readVarint();
+        if (tag & REPEAT) {
+            if ((tag >> 1) >= i) {
+                throw std::runtime_error("AgentIDCodec: Repeated ID refers to a later position");
+            }
+            ids.push_back(ids[tag >> 1]);
+        } else {
+            AgentID id = readID(reader, tag);
+            ids.push_back(id.isBroadcast() ? nullptr : manager->getIDFromBytes(id.getRaw(), id.getSize()));
+        }
+    }
+}
+
+AgentID AgentIDCodec::readID(Reader& reader, uint64_t tag)
+{
+    uint64_t type = tag >> 3;
+    if (type > 0xff) {
+        throw std::runtime_error("AgentIDCodec: Invalid type " + std::to_string(type));
+    }
+    switch ((tag >> 1) & 3) {
+    case RAW: {
+        uint64_t size = reader.readVarint();
+        if (size > static_cast<uint64_t>(AgentID::MAX_SIZE)) {
+            throw std::runtime_error("AgentIDCodec: ID of " + std::to_string(size) + " bytes exceeds the maximum size");
+        }
+        return AgentID(reader.readBytes(size), static_cast<int>(size), static_cast<uint8_t>(type));
+    }
+    case INT: {
+        uint64_t zigzag = reader.readVarint();
+        if (zigzag > 0xffffffff) {
+            throw std::runtime_error("AgentIDCodec: Int ID exceeds 32 bits");
+        }
+        uint32_t value = static_cast<uint32_t>(zigzag >> 1) ^ static_cast<uint32_t>(-static_cast<int32_t>(zigzag & 1));
+        uint8_t bytes[sizeof(value)] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value >> 16),
+                static_cast<uint8_t>(value >> 24)};
+        return AgentID(bytes, sizeof(bytes), static_cast<uint8_t>(type));
+    }
+    case BROADCAST:
+        return AgentID(nullptr, 0, AgentID::BC_TYPE);
+    default:
+        throw std::runtime_error("AgentIDCodec: Unknown form " + std::to_string((tag >> 1) & 3));
+    }
+}
+
+void AgentIDCodec::writeVarint(uint64_t value, std::vector<uint8_t>& out)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+} /* namespace essentials */
@@ -1,37 +1,132 @@
 #include "essentials/AgentIDFactory.h"
 
-#include <uuid/uuid.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
 
-#include <random>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 namespace essentials
 {
 
-AgentIDFactory::AgentIDFactory() {}
+const int AgentIDFactory::POOL_SIZE;
+
+AgentIDFactory::AgentIDFactory()
+        : deterministic(false)
+        , poolPosition(POOL_SIZE)
+{
+}
+
+AgentIDFactory::AgentIDFactory(uint64_t seed)
+        : deterministic(true)
+        , random(seed)
+        , poolPosition(POOL_SIZE)
+{
+}
 
 AgentIDFactory::~AgentIDFactory() {}
 
 const AgentID* AgentIDFactory::create(const std::vector<uint8_t>& bytes) const
 {
-    return new AgentID(bytes.data(), bytes.size());
+    return this->create(bytes.data(), bytes.size());
 }
 
+/**
+ * Creates the ID straight from the given bytes, e.g. a part of a message, without copying them into a vector first.
+ */
+const AgentID* AgentIDFactory::create(const uint8_t* bytes, size_t size) const
+{
+    return new AgentID(bytes, size);
+}
+
+/**
+ * @throws std::length_error, if the requested size exceeds AgentID::MAX_SIZE.
+ */
 const AgentID* AgentIDFactory::generateID(int size) const
 {
-    uuid_t uuid; // a UUID is 16 bytes long
-    uuid_generate(uuid);
+    if (size > AgentID::MAX_SIZE) {
+        throw std::length_error("AgentIDFactory: Cannot generate IDs of " + std::to_string(size) + " bytes");
+    }
+    uint8_t bytes[AgentID::MAX_SIZE];
+    this->generateBytes(bytes, size);
+    return new AgentID(bytes, size);
+}
+
+/**
+ * Copies the given number of unused bytes from the pool, which is refilled whenever it runs empty.
+ */
+void AgentIDFactory::generateBytes(uint8_t* bytes, int size) const
+{
+    std::lock_guard<std::mutex> guard(this->mutex);
+    while (size > 0) {
+        if (this->poolPosition == POOL_SIZE) {
+            this->refill();
+        }
+        int count = std::min(size, POOL_SIZE - this->poolPosition);
+        memcpy(bytes, this->pool + this->poolPosition, count);
+        // used bytes are wiped, so they do not linger in memory
+        memset(this->pool + this->poolPosition, 0, count);
+        this->poolPosition += count;
+        bytes += count;
+        size -= count;
+    }
+}
 
-    if (size <= 16) {
-        return new AgentID(uuid, size);
-    } else { // in case you need an id which is longer than 16 bytes
-        std::vector<uint8_t> bytes;
-        while (bytes.size() < size) {
-            for (int i = 0; i < 16; i++) {
-                bytes.push_back(uuid[i]);
+/**
+ * Requires the mutex to be locked.
+ * @throws std::runtime_error, if neither getrandom nor /dev/urandom deliver random bytes.
+ */
+void AgentIDFactory::refill() const
+{
+    if (this->deterministic) {
+        // byte by byte, so the IDs of a seed do not depend on the endianness
+        for (int i = 0; i < POOL_SIZE; i += 8) {
+            uint64_t value = this->random();
+            for (int j = 0; j < 8; j++) {
+                this->pool[i + j] = static_cast<uint8_t>(value >> (8 * j));
             }
         }
-        return new AgentID(bytes.data(), size);
+        this->poolPosition = 0;
+        return;
+    }
+
+    int filled = 0;
+#ifdef SYS_getrandom
+    while (filled < POOL_SIZE) {
+        long result = syscall(SYS_getrandom, this->pool + filled, POOL_SIZE - filled, 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; // e.g. ENOSYS on kernels older than 3.17
+        }
+        filled += result;
+    }
+#endif
+    if (filled < POOL_SIZE) {
+        int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+        while (fd >= 0 && filled < POOL_SIZE) {
+            ssize_t result = read(fd, this->pool + filled, POOL_SIZE - filled);
+            if (result <= 0) {
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            filled += result;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (filled < POOL_SIZE) {
+        throw std::runtime_error(std::string("AgentIDFactory: Could not read random bytes: ") + strerror(errno));
     }
+    this->poolPosition = 0;
 }
 
 } /* namespace essentials */
@@ -1,52 +1,485 @@
 #include "essentials/AgentIDManager.h"
 #include "essentials/AgentIDFactory.h"
+#include "essentials/SharedAgentIDRegistry.h"
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
 namespace essentials
 {
 
+namespace
+{
+/**
+ * Marks the slot of a removed ID, so lock-free readers keep probing past it.
+ */
+const AgentID tombstone;
+} // namespace
+
+AgentIDRef::AgentIDRef()
+        : manager(nullptr)
+        , id(nullptr)
+{
+}
+
+/**
+ * Takes over a reference, which the manager has already counted.
+ */
+AgentIDRef::AgentIDRef(AgentIDManager* manager, const AgentID* id)
+        : manager(manager)
+        , id(id)
+{
+}
+
+AgentIDRef::AgentIDRef(const AgentIDRef& other)
+        : manager(other.manager)
+        , id(other.id)
+{
+    if (this->id != nullptr) {
+        this->manager->addReference(this->id);
+    }
+}
+
+AgentIDRef::AgentIDRef(AgentIDRef&& other)
+        : manager(other.manager)
+        , id(other.id)
+{
+    other.manager = nullptr;
+    other.id = nullptr;
+}
+
+AgentIDRef& AgentIDRef::operator=(AgentIDRef other)
+{
+    std::swap(this->manager, other.manager);
+    std::swap(this->id, other.id);
+    return *this;
+}
+
+AgentIDRef::~AgentIDRef()
+{
+    if (this->id != nullptr) {
+        this->manager->release(this->id);
+    }
+}
+
+AgentIDManager::Table::Table(size_t capacity)
+        : mask(capacity - 1)
+        , size(0)
+        , tombstones(0)
+        , slots(new std::atomic<const AgentID*>[capacity])
+{
+    for (size_t i = 0; i < capacity; i++) {
+        this->slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Registers the lookup in the current epoch. The epoch is read again after the registration, as
+ * the manager could have advanced it in between and already checked the shard for this parity.
+ */
+AgentIDManager::ReadGuard::ReadGuard(AgentIDManager* manager)
+        : count(nullptr)
+{
+    if (!manager->reclaimUnusedIDs) {
+        return;
+    }
+    static thread_local const size_t shard = std::hash<std::thread::id>()(std::this_thread::get_id()) % READER_SHARDS;
+    while (true) {
+        uint64_t epoch = manager->epoch.load();
+        std::atomic<uint32_t>* shardCount = &manager->readers[shard].count[epoch & 1];
+        shardCount->fetch_add(1);
+        if (manager->epoch.load() == epoch) {
+            this->count = shardCount;
+            return;
+        }
+        shardCount->fetch_sub(1);
+    }
+}
+
+AgentIDManager::ReadGuard::~ReadGuard()
+{
+    if (this->count != nullptr) {
+        this->count->fetch_sub(1, std::memory_order_release);
+    }
+}
+
 /**
  * Attention: The idFactory will be deleted by the AgentIDManager's destructor.
  */
-AgentIDManager::AgentIDManager(AgentIDFactory* idFactory)
-        : idFactory(idFactory)
+AgentIDManager::AgentIDManager(AgentIDFactory* idFactory, bool reclaimUnusedIDs)
+        : table(nullptr)
+        , idCount(0)
+        , idFactory(idFactory)
+        , reclaimUnusedIDs(reclaimUnusedIDs)
+        , epoch(0)
+        , handleOffset(0)
+        , sharedRegistryFull(false)
+{
+    for (ReaderShard& shard : this->readers) {
+        shard.count[0].store(0, std::memory_order_relaxed);
+        shard.count[1].store(0, std::memory_order_relaxed);
+    }
+    this->tables.emplace_back(new Table(64));
+    this->table.store(this->tables.back().get(), std::memory_order_release);
+}
+
+/**
+ * Attention: The idFactory and the sharedRegistry will be deleted by the AgentIDManager's destructor.
+ * The factory still generates random IDs, but the registry creates the interned ones.
+ */
+AgentIDManager::AgentIDManager(AgentIDFactory* idFactory, SharedAgentIDRegistry* sharedRegistry)
+        : AgentIDManager(idFactory, false)
 {
+    this->sharedRegistry.reset(sharedRegistry);
+    this->handleOffset = sharedRegistry->getMaxIDs();
 }
 
 AgentIDManager::~AgentIDManager()
 {
     delete this->idFactory;
-    for (auto& id : this->agentIDs) {
-        delete id;
+    Table* current = this->table.load();
+    for (size_t i = 0; i <= current->mask; i++) {
+        const AgentID* id = current->slots[i].load();
+        if (id != &tombstone) {
+            delete id;
+        }
     }
 }
 
+/**
+ * Generates a random ID and interns it, so it gets a handle like all other IDs of this manager.
+ */
 const AgentID* AgentIDManager::generateID(int size)
 {
-    return this->idFactory->generateID(size);
+    std::unique_ptr<const AgentID> generated(this->idFactory->generateID(size));
+    return this->getIDFromBytes(generated->getRaw(), generated->getSize());
+}
+
+/**
+ * @return The interned ID with the given handle or nullptr, if there is none. Does not lock.
+ * If unused IDs are reclaimed, the caller must hold a reference to the ID with the given handle.
+ */
+const AgentID* AgentIDManager::getIDFromHandle(uint32_t handle) const
+{
+    if (handle < this->handleOffset) {
+        return this->sharedRegistry->getIDFromHandle(handle);
+    }
+    handle -= this->handleOffset;
+    if (handle >= this->idCount.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return this->handleChunks[handle / CHUNK_SIZE][handle % CHUNK_SIZE].load(std::memory_order_acquire);
+}
+
+/**
+ * @return The number of handles assigned so far, which are 0 to count - 1. Tables indexed by handle can be sized with it.
+ * Handles of reclaimed IDs are reused, so the count only grows with the number of IDs alive at the same time.
+ */
+uint32_t AgentIDManager::getIDCount() const
+{
+    uint32_t count = this->idCount.load(std::memory_order_acquire);
+    if (this->sharedRegistry && count == 0) {
+        return this->sharedRegistry->getIDCount();
+    }
+    return this->handleOffset + count;
+}
+
+const AgentID* AgentIDManager::getIDFromBytes(const std::vector<uint8_t>& idByteVector)
+{
+    return this->getIDFromBytes(idByteVector.data(), idByteVector.size());
 }
 
 /**
- * If present, returns the ID corresponding to the given prototype.
+ * If present, returns the ID corresponding to the given bytes.
  * Otherwise, it creates a new one, stores and returns it.
  *
- * This method can be used, e.g., for passing a part of a ROS
- * message and receiving a pointer to a corresponding IAgentID object.
+ * Known IDs are found without locking and without creating a temporary ID, only first-time
+ * inserts are serialised. This method can be used, e.g., for passing a part of a ROS
+ * message and receiving a pointer to a corresponding AgentID object.
+ *
+ * The returned ID is pinned, i.e., it is never reclaimed.
  */
-const AgentID* AgentIDManager::getIDFromBytes(const std::vector<uint8_t>& idByteVector)
+const AgentID* AgentIDManager::getIDFromBytes(const uint8_t* idBytes, size_t idSize)
 {
-    if (idByteVector.empty()) { // empty values result in none-id
+    if (idSize == 0) { // empty values result in none-id
         return nullptr;
     }
-    // create tmpID for lookup the ID
-    const AgentID* tmpID = this->idFactory->create(idByteVector);
+    return this->intern(idBytes, idSize, true);
+}
 
-    // make the manager thread-safe
-    std::lock_guard<std::mutex> guard(mutex);
+/**
+ * @return The ID corresponding to the given bytes or nullptr, if it has not been interned. Never interns, so queries
+ * with IDs from the network neither pin them nor use up handles. Does not lock. If unused IDs are reclaimed,
+ * the returned ID is only valid as long as a reference to it is held elsewhere.
+ */
+const AgentID* AgentIDManager::findIDFromBytes(const uint8_t* idBytes, size_t idSize)
+{
+    if (idSize == 0 || idSize > AgentID::MAX_SIZE) {
+        return nullptr;
+    }
+    size_t hash = AgentID::hash(idBytes, idSize);
+    if (this->idCount.load(std::memory_order_acquire) != 0) {
+        ReadGuard guard(this);
+        if (const AgentID* id = find(this->table.load(std::memory_order_acquire), idBytes, idSize, hash)) {
+            return id;
+        }
+    }
+    return this->sharedRegistry ? this->sharedRegistry->findID(idBytes, idSize) : nullptr;
+}
+
+AgentIDRef AgentIDManager::acquireIDFromBytes(const std::vector<uint8_t>& idByteVector)
+{
+    return this->acquireIDFromBytes(idByteVector.data(), idByteVector.size());
+}
+
+/**
+ * Like getIDFromBytes, but returns a reference, which keeps the ID alive without pinning it.
+ */
+AgentIDRef AgentIDManager::acquireIDFromBytes(const uint8_t* idBytes, size_t idSize)
+{
+    if (idSize == 0) {
+        return AgentIDRef();
+    }
+    return AgentIDRef(this, this->intern(idBytes, idSize, false));
+}
+
+/**
+ * @return The ID of the given bytes, which is pinned or carries one more reference.
+ * @throws std::length_error, if the ID is longer than AgentID::MAX_SIZE bytes.
+ */
+const AgentID* AgentIDManager::intern(const uint8_t* idBytes, size_t idSize, bool pin)
+{
+    // checked before a handle is taken, which would be lost otherwise
+    if (idSize > AgentID::MAX_SIZE) {
+        throw std::length_error("AgentIDManager: " + std::to_string(idSize) + " bytes exceed the maximum of " + std::to_string(AgentID::MAX_SIZE) + " bytes");
+    }
+    size_t hash = AgentID::hash(idBytes, idSize);
+    if (this->sharedRegistry) {
+        // IDs, which did not fit into the registry anymore, are only known here
+        if (this->idCount.load(std::memory_order_acquire) != 0) {
+            if (const AgentID* id = find(this->table.load(std::memory_order_acquire), idBytes, idSize, hash)) {
+                return id;
+            }
+        }
+        if (this->sharedRegistryFull.load(std::memory_order_acquire)) {
+            // IDs are never removed, so a full registry stays full and is only searched without locking
+            if (const AgentID* id = this->sharedRegistry->findID(idBytes, idSize)) {
+                return id;
+            }
+        } else {
+            try {
+                return this->sharedRegistry->getIDFromBytes(idBytes, idSize);
+            } catch (const std::length_error& e) {
+                if (!this->sharedRegistryFull.exchange(true)) {
+                    std::cerr << "AgentIDManager: " << e.what() << ", further IDs are only known to this process!" << std::endl;
+                }
+            }
+        }
+    }
+    {
+        ReadGuard guard(this);
+        const AgentID* id = find(this->table.load(std::memory_order_acquire), idBytes, idSize, hash);
+        // fails for an ID, which is being removed, the locked path below then creates it anew
+        if (id != nullptr && this->tryAddReference(id, pin)) {
+            return id;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+    // another thread could have been faster
+    Table* current = this->table.load(std::memory_order_relaxed);
+    if (const AgentID* id = find(current, idBytes, idSize, hash)) {
+        // the last reference of a listed ID is only dropped with the mutex locked
+        this->tryAddReference(id, pin);
+        return id;
+    }
+    uint32_t handle;
+    if (!this->freeHandles.empty()) {
+        handle = this->freeHandles.back();
+        this->freeHandles.pop_back();
+    } else {
+        handle = this->idCount.load(std::memory_order_relaxed);
+        if (handle == CHUNK_SIZE * MAX_CHUNKS) {
+            throw std::length_error("AgentIDManager: No handles left for further IDs");
+        }
+        if (!this->handleChunks[handle / CHUNK_SIZE]) {
+            this->handleChunks[handle / CHUNK_SIZE].reset(new std::atomic<const AgentID*>[CHUNK_SIZE]);
+            this->refChunks[handle / CHUNK_SIZE].reset(new std::atomic<uint32_t>[CHUNK_SIZE]);
+        }
+    }
+    AgentID* id = const_cast<AgentID*>(this->idFactory->create(idBytes, idSize));
+    id->handle = this->handleOffset + handle;
+    this->getReferences(handle).store(pin || !this->reclaimUnusedIDs ? PINNED : 1, std::memory_order_relaxed);
+    this->handleChunks[handle / CHUNK_SIZE][handle % CHUNK_SIZE].store(id, std::memory_order_release);
+    if (handle == this->idCount.load(std::memory_order_relaxed)) {
+        this->idCount.store(handle + 1, std::memory_order_release);
+    }
+
+    // keep the load factor including tombstones below 1/2, so probe sequences stay short and end
+    if (2 * (current->size + current->tombstones + 1) > current->mask + 1) {
+        size_t capacity = 64;
+        while (capacity < 4 * (current->size + 1)) {
+            capacity *= 2;
+        }
+        Table* fresh = new Table(capacity);
+        for (size_t i = 0; i <= current->mask; i++) {
+            const AgentID* existing = current->slots[i].load(std::memory_order_relaxed);
+            if (existing != nullptr && existing != &tombstone) {
+                insert(fresh, existing, existing->hash());
+            }
+        }
+        this->tables.emplace_back(fresh);
+        insert(fresh, id, hash);
+        this->table.store(fresh, std::memory_order_release);
+        if (this->reclaimUnusedIDs) {
+            this->retired.push_back(Retired{this->epoch.load(), nullptr, std::move(this->tables.front())});
+            this->tables.erase(this->tables.begin());
+            this->reclaim();
+        }
+    } else {
+        insert(current, id, hash);
+    }
+    return id;
+}
+
+/**
+ * Adds a reference to, or pins, the given ID, unless its last reference is already gone.
+ */
+bool AgentIDManager::tryAddReference(const AgentID* id, bool pin)
+{
+    if (!this->reclaimUnusedIDs) { // all IDs are pinned
+        return true;
+    }
+    std::atomic<uint32_t>& references = this->getReferences(id->getHandle());
+    uint32_t count = references.load(std::memory_order_relaxed);
+    do {
+        if (count & PINNED) {
+            return true;
+        }
+        if (count == 0) {
+            return false;
+        }
+    } while (!references.compare_exchange_weak(count, pin ? count | PINNED : count + 1, std::memory_order_acq_rel));
+    return true;
+}
 
-    // lookup the ID and insert it, if not available, yet
-    auto entry = this->agentIDs.insert(tmpID);
-    if (!entry.second) { // delete tmpID if already present in agentIDs
-        delete tmpID;
+/**
+ * Requires the caller to hold a reference to the given ID.
+ */
+void AgentIDManager::addReference(const AgentID* id)
+{
+    if (this->sharedRegistry) {
+        return;
+    }
+    this->tryAddReference(id, false);
+}
+
+/**
+ * Drops a reference to the given ID. Dropping the last one removes the ID with the mutex locked,
+ * so lookups, which find it under the mutex, can always add a reference.
+ */
+void AgentIDManager::release(const AgentID* id)
+{
+    if (this->sharedRegistry) {
+        return;
+    }
+    std::atomic<uint32_t>& references = this->getReferences(id->getHandle());
+    uint32_t count = references.load(std::memory_order_relaxed);
+    while (!(count & PINNED) && count > 1) {
+        if (references.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel)) {
+            return;
+        }
+    }
+    if (count & PINNED) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(this->mutex);
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        this->remove(id);
+    }
+}
+
+/**
+ * Replaces the ID's slot by a tombstone and retires the ID. Requires the mutex to be locked.
+ */
+void AgentIDManager::remove(const AgentID* id)
+{
+    Table* current = this->table.load(std::memory_order_relaxed);
+    for (size_t i = id->hash() & current->mask;; i = (i + 1) & current->mask) {
+        if (current->slots[i].load(std::memory_order_relaxed) == id) {
+            current->slots[i].store(&tombstone, std::memory_order_release);
+            break;
+        }
+    }
+    current->size--;
+    current->tombstones++;
+    this->handleChunks[id->getHandle() / CHUNK_SIZE][id->getHandle() % CHUNK_SIZE].store(nullptr, std::memory_order_relaxed);
+    this->retired.push_back(Retired{this->epoch.load(), std::unique_ptr<const AgentID>(id), nullptr});
+    this->reclaim();
+}
+
+/**
+ * Advances the epoch, if no lookup of the previous epoch is still in progress, and frees everything
+ * retired two epochs ago or earlier. Any lookup, which could see it, has ended by then, as lookups
+ * in progress block the advance past their epoch's successor. Requires the mutex to be locked.
+ */
+void AgentIDManager::reclaim()
+{
+    uint64_t current = this->epoch.load();
+    for (int advance = 0; advance < 2; advance++) {
+        uint32_t active = 0;
+        for (ReaderShard& shard : this->readers) {
+            active += shard.count[(current - 1) & 1].load();
+        }
+        if (active != 0) {
+            break;
+        }
+        this->epoch.store(++current);
+    }
+    while (!this->retired.empty() && this->retired.front().epoch + 2 <= current) {
+        if (this->retired.front().id) {
+            this->freeHandles.push_back(this->retired.front().id->getHandle());
+        }
+        this->retired.pop_front();
+    }
+}
+
+const AgentID* AgentIDManager::find(const Table* table, const uint8_t* idBytes, size_t idSize, size_t hash)
+{
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        const AgentID* id = table->slots[i].load(std::memory_order_acquire);
+        if (id == nullptr) {
+            return nullptr;
+        }
+        if (id != &tombstone && static_cast<size_t>(id->getSize()) == idSize && memcmp(id->getRaw(), idBytes, idSize) == 0) {
+            return id;
+        }
+    }
+}
+
+/**
+ * Stores the given ID in the first free slot or tombstone of its probe sequence. Requires the mutex to be locked.
+ */
+void AgentIDManager::insert(Table* table, const AgentID* id, size_t hash)
+{
+    size_t i = hash & table->mask;
+    while (true) {
+        const AgentID* slot = table->slots[i].load(std::memory_order_relaxed);
+        if (slot == nullptr) {
+            break;
+        }
+        if (slot == &tombstone) {
+            table->tombstones--;
+            break;
+        }
+        i = (i + 1) & table->mask;
     }
-    return *(entry.first);
+    table->slots[i].store(id, std::memory_order_release);
+    table->size++;
 }
 } // namespace essentials
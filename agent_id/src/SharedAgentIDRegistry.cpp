@@ -0,0 +1,354 @@
+#include "essentials/SharedAgentIDRegistry.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace essentials
+{
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "The shared registry requires address-free atomics");
+
+namespace
+{
+const uint32_t MAGIC = 0x41494452; // "AIDR"
+const uint32_t VERSION = 1;
+const int OPEN_TIMEOUT_MS = 2000;
+const char HASH_PROBE[] = "AgentID";
+
+size_t alignUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+std::string error(const std::string& name, const std::string& message)
+{
+    return "SharedAgentIDRegistry: " + name + ": " + message;
+}
+} // namespace
+
+/**
+ * Layout of the segment: the header, then the slots of the table, then the IDs.
+ */
+struct SharedAgentIDRegistry::Header
+{
+    std::atomic<uint32_t> magic; /**< Set last by the creator */
+    uint32_t version;
+    uint32_t idLayoutSize;  /**< sizeof(AgentID), to detect incompatible builds */
+    uint64_t hashProbe;     /**< Hash of HASH_PROBE, to detect incompatible hash functions */
+    uint32_t maxIDs;
+    uint32_t mask;
+    std::atomic<uint32_t> idCount;
+    pthread_mutex_t mutex;
+};
+
+/**
+ * Opens the segment of the given name or creates it with room for maxIDs IDs, if it does not exist.
+ * @throws std::runtime_error, if the segment cannot be opened or was created by an incompatible build.
+ */
+SharedAgentIDRegistry::SharedAgentIDRegistry(const std::string& name, uint32_t maxIDs)
+        : name(toSegmentName(name))
+        , segment(nullptr)
+        , segmentSize(0)
+        , header(nullptr)
+        , slots(nullptr)
+        , ids(nullptr)
+        , maxIDs(0)
+        , mask(0)
+{
+    if (maxIDs == 0 || maxIDs > (1u << 30)) {
+        throw std::invalid_argument(error(this->name, "Invalid number of IDs " + std::to_string(maxIDs)));
+    }
+    this->map(maxIDs);
+}
+
+/**
+ * Unmaps the segment, which stays available to the other processes.
+ */
+SharedAgentIDRegistry::~SharedAgentIDRegistry()
+{
+    munmap(this->segment, this->segmentSize);
+}
+
+/**
+ * Removes the segment of the given name. Processes, which have mapped it, keep their mapping.
+ */
+bool SharedAgentIDRegistry::remove(const std::string& name)
+{
+    return shm_unlink(toSegmentName(name).c_str()) == 0;
+}
+
+std::string SharedAgentIDRegistry::toSegmentName(const std::string& name)
+{
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+void SharedAgentIDRegistry::map(uint32_t maxIDs)
+{
+    int fd = shm_open(this->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    bool creator = fd >= 0;
+    if (!creator) {
+        if (errno != EEXIST) {
+            throw std::runtime_error(error(this->name, std::string("Cannot create segment: ") + strerror(errno)));
+        }
+        fd = shm_open(this->name.c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            throw std::runtime_error(error(this->name, std::string("Cannot open segment: ") + strerror(errno)));
+        }
+    }
+
+    size_t slotCount = 64;
+    while (slotCount < 2 * static_cast<size_t>(maxIDs)) {
+        slotCount *= 2;
+    }
+    size_t slotsOffset = alignUp(sizeof(Header), 64);
+    size_t idsOffset = alignUp(slotsOffset + slotCount * sizeof(std::atomic<uint32_t>), 64);
+
+    if (creator) {
+        this->segmentSize = idsOffset + maxIDs * sizeof(AgentID);
+        if (ftruncate(fd, this->segmentSize) != 0) {
+            int errorNumber = errno;
+            close(fd);
+            shm_unlink(this->name.c_str());
+            throw std::runtime_error(error(this->name, std::string("Cannot size segment: ") + strerror(errorNumber)));
+        }
+    } else {
+        // the creator may not have sized the segment yet
+        struct stat status;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(OPEN_TIMEOUT_MS);
+        while (true) {
+            if (fstat(fd, &status) != 0) {
+                int errorNumber = errno;
+                close(fd);
+                throw std::runtime_error(error(this->name, std::string("Cannot stat segment: ") + strerror(errorNumber)));
+            }
+            if (status.st_size != 0 || std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        this->segmentSize = status.st_size;
+        if (this->segmentSize < sizeof(Header)) {
+            close(fd);
+            throw std::runtime_error(error(this->name, "Segment was not initialised in time"));
+        }
+    }
+
+    this->segment = mmap(nullptr, this->segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (this->segment == MAP_FAILED) {
+        this->segment = nullptr;
+        throw std::runtime_error(error(this->name, std::string("Cannot map segment: ") + strerror(errno)));
+    }
+    this->header = static_cast<Header*>(this->segment);
+
+    if (creator) {
+        // the fresh segment is zero filled, so the table is empty and the ID count is 0
+        this->header->version = VERSION;
+        this->header->idLayoutSize = sizeof(AgentID);
+        this->header->hashProbe = AgentID::hash(reinterpret_cast<const uint8_t*>(HASH_PROBE), sizeof(HASH_PROBE) - 1);
+        this->header->maxIDs = maxIDs;
+        this->header->mask = slotCount - 1;
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&this->header->mutex, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+        this->header->magic.store(MAGIC, std::memory_order_release);
+    } else {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(OPEN_TIMEOUT_MS);
+        while (this->header->magic.load(std::memory_order_acquire) != MAGIC && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::string problem;
+        if (this->header->magic.load(std::memory_order_acquire) != MAGIC) {
+            problem = "Segment was not initialised in time, remove it, if its creator died";
+        } else if (this->header->version != VERSION || this->header->idLayoutSize != sizeof(AgentID) ||
+                   this->header->hashProbe != AgentID::hash(reinterpret_cast<const uint8_t*>(HASH_PROBE), sizeof(HASH_PROBE) - 1)) {
+            problem = "Segment was created by an incompatible build";
+        } else {
+            maxIDs = this->header->maxIDs;
+            slotCount = static_cast<size_t>(this->header->mask) + 1;
+            idsOffset = alignUp(slotsOffset + slotCount * sizeof(std::atomic<uint32_t>), 64);
+            if (maxIDs == 0 || maxIDs > (1u << 30) || (slotCount & (slotCount - 1)) != 0 || slotCount < 2 * static_cast<size_t>(maxIDs)) {
+                problem = "Segment is corrupted";
+            } else if (this->segmentSize < idsOffset + maxIDs * sizeof(AgentID)) {
+                problem = "Segment is truncated";
+            }
+        }
+        if (!problem.empty()) {
+            munmap(this->segment, this->segmentSize);
+            this->segment = nullptr;
+            throw std::runtime_error(error(this->name, problem));
+        }
+    }
+    this->slots = reinterpret_cast<std::atomic<uint32_t>*>(static_cast<char*>(this->segment) + slotsOffset);
+    this->ids = reinterpret_cast<AgentID*>(static_cast<char*>(this->segment) + idsOffset);
+    this->maxIDs = maxIDs;
+    this->mask = slotCount - 1;
+}
+
+/**
+ * If present, returns the ID corresponding to the given bytes. Otherwise, it stores a new one in the segment and returns it.
+ * @throws std::length_error, if the segment is full.
+ */
+const AgentID* SharedAgentIDRegistry::getIDFromBytes(const uint8_t* idBytes, size_t idSize)
+{
+    if (idSize == 0) {
+        return nullptr;
+    }
+    if (idSize > static_cast<size_t>(AgentID::MAX_SIZE)) {
+        throw std::length_error(error(this->name, std::to_string(idSize) + " bytes exceed the maximum ID size"));
+    }
+    size_t hash = AgentID::hash(idBytes, idSize);
+    if (const AgentID* id = this->find(idBytes, idSize, hash)) {
+        return id;
+    }
+
+    this->lock();
+    try {
+        // another process could have been faster
+        if (const AgentID* id = this->find(idBytes, idSize, hash)) {
+            this->unlock();
+            return id;
+        }
+        uint32_t handle = this->loadIDCount();
+        if (handle == this->maxIDs) {
+            throw std::length_error(error(this->name, "No room left for further IDs"));
+        }
+        AgentID* id = &this->ids[handle];
+        *id = AgentID(idBytes, idSize);
+        id->handle = handle;
+        this->header->idCount.store(handle + 1, std::memory_order_release);
+        this->insert(handle, hash);
+        this->unlock();
+        return id;
+    } catch (...) {
+        this->unlock();
+        throw;
+    }
+}
+
+/**
+ * @return The ID corresponding to the given bytes or nullptr, if it is not in the segment. Neither locks nor inserts.
+ */
+const AgentID* SharedAgentIDRegistry::findID(const uint8_t* idBytes, size_t idSize) const
+{
+    if (idSize == 0 || idSize > static_cast<size_t>(AgentID::MAX_SIZE)) {
+        return nullptr;
+    }
+    return this->find(idBytes, idSize, AgentID::hash(idBytes, idSize));
+}
+
+/**
+ * @return The ID with the given handle or nullptr, if there is none. Does not lock.
+ */
+const AgentID* SharedAgentIDRegistry::getIDFromHandle(uint32_t handle) const
+{
+    if (handle >= this->loadIDCount()) {
+        return nullptr;
+    }
+    return &this->ids[handle];
+}
+
+uint32_t SharedAgentIDRegistry::getIDCount() const
+{
+    return this->loadIDCount();
+}
+
+uint32_t SharedAgentIDRegistry::getMaxIDs() const
+{
+    return this->maxIDs;
+}
+
+/**
+ * @return The number of IDs in the segment, which never exceeds the checked capacity.
+ */
+uint32_t SharedAgentIDRegistry::loadIDCount() const
+{
+    return std::min(this->header->idCount.load(std::memory_order_acquire), this->maxIDs);
+}
+
+void SharedAgentIDRegistry::lock()
+{
+    int result = pthread_mutex_lock(&this->header->mutex);
+    if (result == EOWNERDEAD) {
+        pthread_mutex_consistent(&this->header->mutex);
+        try {
+            this->repair();
+        } catch (...) {
+            this->unlock();
+            throw;
+        }
+    } else if (result != 0) {
+        throw std::runtime_error(error(this->name, std::string("Cannot lock: ") + strerror(result)));
+    }
+}
+
+void SharedAgentIDRegistry::unlock()
+{
+    pthread_mutex_unlock(&this->header->mutex);
+}
+
+/**
+ * An owner, which died while inserting, may have counted its ID without storing it in the table.
+ * Requires the mutex to be locked.
+ */
+void SharedAgentIDRegistry::repair()
+{
+    uint32_t count = this->loadIDCount();
+    for (uint32_t handle = 0; handle < count; handle++) {
+        const AgentID& id = this->ids[handle];
+        if (this->find(id.getRaw(), id.getSize(), id.hash()) == nullptr) {
+            this->insert(handle, id.hash());
+        }
+    }
+}
+
+/**
+ * @throws std::runtime_error, if the table holds a handle beyond the IDs or has no free slot left.
+ */
+const AgentID* SharedAgentIDRegistry::find(const uint8_t* idBytes, size_t idSize, size_t hash) const
+{
+    for (size_t i = hash & this->mask, probes = 0; probes <= this->mask; i = (i + 1) & this->mask, probes++) {
+        uint32_t slot = this->slots[i].load(std::memory_order_acquire);
+        if (slot == 0) {
+            return nullptr;
+        }
+        if (slot - 1 >= this->maxIDs) {
+            throw std::runtime_error(error(this->name, "Segment is corrupted, slot " + std::to_string(i) + " holds handle " + std::to_string(slot - 1)));
+        }
+        const AgentID* id = &this->ids[slot - 1];
+        if (static_cast<size_t>(id->getSize()) == idSize && memcmp(id->getRaw(), idBytes, idSize) == 0) {
+            return id;
+        }
+    }
+    throw std::runtime_error(error(this->name, "Segment is corrupted, its table has no free slot"));
+}
+
+/**
+ * Stores the handle in the first free slot of its probe sequence, the table has twice as many slots as IDs.
+ * Requires the mutex to be locked.
+ */
+void SharedAgentIDRegistry::insert(uint32_t handle, size_t hash)
+{
+    for (size_t i = hash & this->mask, probes = 0; probes <= this->mask; i = (i + 1) & this->mask, probes++) {
+        if (this->slots[i].load(std::memory_order_relaxed) == 0) {
+            this->slots[i].store(handle + 1, std::memory_order_release);
+            return;
+        }
+    }
+    throw std::runtime_error(error(this->name, "Segment is corrupted, its table has no free slot"));
+}
+
+} /* namespace essentials */
@@ -0,0 +1,328 @@
+#include "essentials/AgentID.h"
+#include "essentials/AgentIDFactory.h"
+#include "essentials/AgentIDManager.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+/**
+ * The MurmurHash3 (32 bit) variant AgentID used before its hash was cached, kept as the baseline.
+ */
+size_t murmurHash(const uint8_t* key, int len)
+{
+    uint32_t h = 13;
+    if (len > 3) {
+        const uint8_t* p = key;
+        size_t i = len >> 2;
+        do {
+            uint32_t k;
+            memcpy(&k, p, sizeof(k));
+            k *= 0xcc9e2d51;
+            k = (k << 15) | (k >> 17);
+            k *= 0x1b873593;
+            h ^= k;
+            h = (h << 13) | (h >> 19);
+            h = (h * 5) + 0xe6546b64;
+            p += sizeof(k);
+        } while (--i);
+        key = p;
+    }
+    if (len & 3) {
+        size_t i = len & 3;
+        uint32_t k = 0;
+        key = &key[i - 1];
+        do {
+            k <<= 8;
+            k |= *key--;
+        } while (--i);
+        k *= 0xcc9e2d51;
+        k = (k << 15) | (k >> 17);
+        k *= 0x1b873593;
+        h ^= k;
+    }
+    h ^= len;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+size_t wyHash(const uint8_t* key, int len)
+{
+    return essentials::AgentID::hash(key, len);
+}
+
+/**
+ * Sequential integers for 4 byte IDs, as robots are usually numbered, random bytes otherwise.
+ */
+std::vector<std::vector<uint8_t>> createKeys(int size, size_t count)
+{
+    std::mt19937_64 random(42);
+    std::vector<std::vector<uint8_t>> keys(count, std::vector<uint8_t>(size));
+    for (size_t i = 0; i < count; i++) {
+        if (size == sizeof(int)) {
+            int value = static_cast<int>(i);
+            memcpy(keys[i].data(), &value, sizeof(value));
+        } else {
+            for (uint8_t& byte : keys[i]) {
+                byte = static_cast<uint8_t>(random());
+            }
+        }
+    }
+    return keys;
+}
+
+template <size_t (*Hash)(const uint8_t*, int)>
+void BM_Hash(benchmark::State& state)
+{
+    int size = state.range(0);
+    std::vector<std::vector<uint8_t>> keys = createKeys(size, 1024);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Hash(keys[i].data(), size));
+        i = (i + 1) & 1023;
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+/**
+ * Hashes 4096 keys into 4096 buckets of a power-of-two table, like the one of AgentIDManager, which
+ * only uses the low bits. Reports the longest bucket and the chi-squared statistic of the bucket
+ * loads divided by the number of buckets, which is about 1 for a uniform hash.
+ */
+template <size_t (*Hash)(const uint8_t*, int)>
+void BM_HashDistribution(benchmark::State& state)
+{
+    int size = state.range(0);
+    const size_t buckets = 4096;
+    std::vector<std::vector<uint8_t>> keys = createKeys(size, buckets);
+    std::vector<size_t> loads(buckets);
+    for (auto _ : state) {
+        std::fill(loads.begin(), loads.end(), 0);
+        for (const std::vector<uint8_t>& key : keys) {
+            loads[Hash(key.data(), size) & (buckets - 1)]++;
+        }
+        benchmark::DoNotOptimize(loads.data());
+    }
+    double chiSquared = 0;
+    for (size_t load : loads) {
+        chiSquared += (load - 1.0) * (load - 1.0);
+    }
+    state.counters["maxBucket"] = *std::max_element(loads.begin(), loads.end());
+    state.counters["chiSquared"] = chiSquared / buckets;
+}
+
+void BM_CachedHash(benchmark::State& state)
+{
+    std::vector<std::vector<uint8_t>> keys = createKeys(state.range(0), 1024);
+    std::vector<essentials::AgentID> ids;
+    for (const std::vector<uint8_t>& key : keys) {
+        ids.emplace_back(key.data(), key.size());
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ids[i].hash());
+        i = (i + 1) & 1023;
+    }
+}
+
+template <bool Seeded>
+void BM_GenerateID(benchmark::State& state)
+{
+    std::unique_ptr<essentials::AgentIDFactory> factory(Seeded ? new essentials::AgentIDFactory(42) : new essentials::AgentIDFactory());
+    for (auto _ : state) {
+        std::unique_ptr<const essentials::AgentID> id(factory->generateID(state.range(0)));
+        benchmark::DoNotOptimize(id.get());
+    }
+}
+
+// shared by the threads of the multi-threaded benchmarks, set up and torn down by thread 0
+std::unique_ptr<essentials::AgentIDManager> sharedManager;
+
+/**
+ * Lookups of known IDs, which take the lock-free path of the manager.
+ */
+void BM_GetIDFromBytesHit(benchmark::State& state)
+{
+    const int count = 1024;
+    if (state.thread_index() == 0) {
+        sharedManager.reset(new essentials::AgentIDManager(new essentials::AgentIDFactory()));
+        for (int i = 0; i < count; i++) {
+            sharedManager->getID<int>(i);
+        }
+    }
+    int i = state.thread_index();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sharedManager->getIDFromBytes(reinterpret_cast<const uint8_t*>(&i), sizeof(i)));
+        i = (i + 1) & (count - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        sharedManager.reset();
+    }
+}
+
+/**
+ * Lookups of unknown IDs, which insert them under the manager's mutex. The iterations are bounded,
+ * as every one of them adds an ID.
+ */
+void BM_GetIDFromBytesMiss(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        sharedManager.reset(new essentials::AgentIDManager(new essentials::AgentIDFactory()));
+    }
+    // the thread index in the upper bytes keeps the IDs of the threads apart
+    int i = state.thread_index() << 24;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sharedManager->getIDFromBytes(reinterpret_cast<const uint8_t*>(&i), sizeof(i)));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        sharedManager.reset();
+    }
+}
+
+/**
+ * Acquires and releases unknown IDs, i.e., inserts and removes them with epoch-based reclamation.
+ */
+void BM_AcquireAndReleaseMiss(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        sharedManager.reset(new essentials::AgentIDManager(new essentials::AgentIDFactory(), true));
+    }
+    int i = state.thread_index() << 24;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sharedManager->acquireIDFromBytes(reinterpret_cast<const uint8_t*>(&i), sizeof(i)).get());
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        sharedManager.reset();
+    }
+}
+
+void BM_ManagerGenerateID(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        sharedManager.reset(new essentials::AgentIDManager(new essentials::AgentIDFactory(42)));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sharedManager->generateID());
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        sharedManager.reset();
+    }
+}
+
+/**
+ * IDs of robots as they are kept in maps of the process manager and PMControl, in random order.
+ */
+std::vector<const essentials::AgentID*> createInternedIDs(essentials::AgentIDManager& manager, int count)
+{
+    std::vector<const essentials::AgentID*> ids;
+    for (int i = 0; i < count; i++) {
+        ids.push_back(i % 2 == 0 ? manager.getID<int>(i) : manager.generateID());
+    }
+    std::shuffle(ids.begin(), ids.end(), std::mt19937_64(42));
+    return ids;
+}
+
+template <typename Map>
+void BM_ValueMapFind(benchmark::State& state)
+{
+    essentials::AgentIDManager manager(new essentials::AgentIDFactory(42));
+    std::vector<const essentials::AgentID*> ids = createInternedIDs(manager, state.range(0));
+    Map map;
+    for (const essentials::AgentID* id : ids) {
+        map.emplace(*id, 0);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.find(*ids[i]));
+        i = (i + 1) % ids.size();
+    }
+}
+
+template <typename Comparator>
+void BM_PointerMapFind(benchmark::State& state)
+{
+    essentials::AgentIDManager manager(new essentials::AgentIDFactory(42));
+    std::vector<const essentials::AgentID*> ids = createInternedIDs(manager, state.range(0));
+    std::map<const essentials::AgentID*, int, Comparator> map;
+    for (const essentials::AgentID* id : ids) {
+        map.emplace(id, 0);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.find(ids[i]));
+        i = (i + 1) % ids.size();
+    }
+}
+
+void BM_UnorderedPointerMapFind(benchmark::State& state)
+{
+    essentials::AgentIDManager manager(new essentials::AgentIDFactory(42));
+    std::vector<const essentials::AgentID*> ids = createInternedIDs(manager, state.range(0));
+    std::unordered_map<const essentials::AgentID*, int, essentials::AgentIDHash, essentials::AgentIDEqualsComparator> map;
+    for (const essentials::AgentID* id : ids) {
+        map.emplace(id, 0);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(map.find(ids[i]));
+        i = (i + 1) % ids.size();
+    }
+}
+
+/**
+ * Builds a set of all IDs and clears it again, i.e., inserts with allocations.
+ */
+template <typename Comparator>
+void BM_PointerSetInsert(benchmark::State& state)
+{
+    essentials::AgentIDManager manager(new essentials::AgentIDFactory(42));
+    std::vector<const essentials::AgentID*> ids = createInternedIDs(manager, state.range(0));
+    for (auto _ : state) {
+        std::set<const essentials::AgentID*, Comparator> set(ids.begin(), ids.end());
+        benchmark::DoNotOptimize(set.size());
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Hash, murmurHash)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK_TEMPLATE(BM_Hash, wyHash)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK_TEMPLATE(BM_HashDistribution, murmurHash)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_HashDistribution, wyHash)->Arg(4)->Arg(16);
+BENCHMARK(BM_CachedHash)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_GenerateID, false)->Arg(16)->Arg(32);
+BENCHMARK_TEMPLATE(BM_GenerateID, true)->Arg(16)->Arg(32);
+BENCHMARK(BM_ManagerGenerateID)->ThreadRange(1, 64)->UseRealTime();
+
+BENCHMARK(BM_GetIDFromBytesHit)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_GetIDFromBytesMiss)->ThreadRange(1, 64)->Iterations(20000)->UseRealTime();
+BENCHMARK(BM_AcquireAndReleaseMiss)->ThreadRange(1, 64)->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_ValueMapFind, std::map<essentials::AgentID, int>)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_ValueMapFind, std::unordered_map<essentials::AgentID, int>)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_PointerMapFind, essentials::AgentIDComparator)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_PointerMapFind, essentials::AgentIDHandleComparator)->Range(16, 1024);
+BENCHMARK(BM_UnorderedPointerMapFind)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_PointerSetInsert, essentials::AgentIDComparator)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_PointerSetInsert, essentials::AgentIDHandleComparator)->Range(16, 1024);
+
+BENCHMARK_MAIN();
@@ -1,11 +1,20 @@
 #include <essentials/AgentID.h>
+#include <essentials/AgentIDCodec.h>
 #include <essentials/AgentIDFactory.h>
 #include <essentials/AgentIDManager.h>
-#include <essentials/BroadcastID.h>
+#include <essentials/SharedAgentIDRegistry.h>
 
 #include <gtest/gtest.h>
+#include <memory>
+#include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 TEST(AgentID, ConstructorCopiesBytes)
 {
     std::vector<uint8_t> bytes1;
@@ -22,7 +31,7 @@ TEST(AgentID, ConstructorCopiesBytes)
 TEST(AgentID, ConstructionOfHugeID)
 {
     std::vector<uint8_t> bytes1;
-    int size = 100;
+    int size = essentials::AgentID::MAX_SIZE;
     for (int i = 0; i < size; i++) {
         bytes1.push_back(i);
     }
@@ -33,10 +42,30 @@ TEST(AgentID, ConstructionOfHugeID)
     delete id1;
 }
 
+TEST(AgentID, OversizedIDThrows)
+{
+    std::vector<uint8_t> bytes1(essentials::AgentID::MAX_SIZE + 1, 1);
+    ASSERT_THROW(essentials::AgentID(bytes1.data(), bytes1.size()), std::length_error);
+}
+
+TEST(AgentID, CopiesAreEqualValues)
+{
+    std::vector<uint8_t> bytes1;
+    for (int i = 0; i < 16; i++) {
+        bytes1.push_back(i);
+    }
+    essentials::AgentID id1(bytes1.data(), bytes1.size());
+    essentials::AgentID id2 = id1;
+
+    ASSERT_TRUE(id1 == id2);
+    ASSERT_NE(id1.getRaw(), id2.getRaw());
+    ASSERT_EQ(std::hash<essentials::AgentID>()(id1), std::hash<essentials::AgentID>()(id2));
+}
+
 TEST(AgentID, ToByteVectorReturnsCopy)
 {
     std::vector<uint8_t> bytes1;
-    int size = 100;
+    int size = essentials::AgentID::MAX_SIZE;
     for (int i = 0; i < size; i++) {
         bytes1.push_back(i);
     }
@@ -65,6 +94,26 @@ TEST(AgentID, HashEqualForSameIDs)
     delete id2;
 }
 
+TEST(AgentID, CachedHashMatchesBytes)
+{
+    uint8_t bytes[essentials::AgentID::MAX_SIZE];
+    for (int i = 0; i < essentials::AgentID::MAX_SIZE; i++) {
+        bytes[i] = i * 7;
+    }
+    for (int size = 0; size <= essentials::AgentID::MAX_SIZE; size++) {
+        essentials::AgentID id(bytes, size);
+        ASSERT_EQ(essentials::AgentID::hash(bytes, size), id.hash());
+    }
+    // every byte of the 4 to 16 byte paths takes part in the hash
+    essentials::AgentID id(bytes, 16);
+    for (int i = 0; i < 16; i++) {
+        bytes[i]++;
+        ASSERT_NE(id.hash(), essentials::AgentID(bytes, 16).hash());
+        bytes[i]--;
+    }
+    ASSERT_EQ(0u, essentials::AgentID::broadcast().hash());
+}
+
 TEST(AgentID, EqualWithSameID)
 {
     std::vector<uint8_t> bytes1;
@@ -108,9 +157,11 @@ TEST(BroadCastID, NotEqualWithNormalID)
     }
     essentials::AgentID* normalID = new essentials::AgentID(bytes1.data(), bytes1.size());
     std::vector<uint8_t> bytesBroadcast;
-    essentials::AgentID* broadcastID = new essentials::BroadcastID(bytesBroadcast.data(), bytesBroadcast.size());
+    essentials::AgentID* broadcastID = new essentials::AgentID(bytesBroadcast.data(), bytesBroadcast.size(), essentials::AgentID::BC_TYPE);
 
     ASSERT_FALSE(*broadcastID == *normalID);
+    ASSERT_FALSE(*normalID == *broadcastID);
+    ASSERT_TRUE(*broadcastID < *normalID);
 
     delete normalID;
     delete broadcastID;
@@ -120,11 +171,13 @@ TEST(BroadCastID, EqualWithBroadcastID)
 {
     std::vector<uint8_t> bytesBroadcast1;
     bytesBroadcast1.push_back(1);
-    essentials::AgentID* broadcastID1 = new essentials::BroadcastID(bytesBroadcast1.data(), bytesBroadcast1.size());
+    essentials::AgentID* broadcastID1 = new essentials::AgentID(bytesBroadcast1.data(), bytesBroadcast1.size(), essentials::AgentID::BC_TYPE);
     std::vector<uint8_t> bytesBroadcast2;
-    essentials::AgentID* broadcastID2 = new essentials::BroadcastID(bytesBroadcast2.data(), bytesBroadcast2.size());
+    essentials::AgentID* broadcastID2 = new essentials::AgentID(bytesBroadcast2.data(), bytesBroadcast2.size(), essentials::AgentID::BC_TYPE);
 
     ASSERT_TRUE(*broadcastID1 == *broadcastID2);
+    ASSERT_TRUE(*broadcastID1 == essentials::AgentID::broadcast());
+    ASSERT_FALSE(*broadcastID1 < *broadcastID2);
 
     delete broadcastID1;
     delete broadcastID2;
@@ -155,6 +208,31 @@ TEST(AgentIDFactory, DuplicateIDs)
     ASSERT_TRUE(*id18 == *id18Copy);
 }
 
+TEST(AgentIDFactory, SeededFactoriesReproduceIDs)
+{
+    essentials::AgentIDFactory factory1(42);
+    essentials::AgentIDFactory factory2(42);
+    essentials::AgentIDFactory other(43);
+    ASSERT_TRUE(factory1.isDeterministic());
+    // more IDs than fit into one pool, so refills are covered as well
+    for (int i = 0; i < 1000; i++) {
+        std::unique_ptr<const essentials::AgentID> id1(factory1.generateID(essentials::AgentID::MAX_SIZE));
+        std::unique_ptr<const essentials::AgentID> id2(factory2.generateID(essentials::AgentID::MAX_SIZE));
+        std::unique_ptr<const essentials::AgentID> id3(other.generateID(essentials::AgentID::MAX_SIZE));
+        ASSERT_TRUE(*id1 == *id2);
+        ASSERT_FALSE(*id1 == *id3);
+    }
+}
+
+TEST(AgentIDFactory, LongIDsDoNotRepeatBytes)
+{
+    essentials::AgentIDFactory factory;
+    ASSERT_FALSE(factory.isDeterministic());
+    std::unique_ptr<const essentials::AgentID> id(factory.generateID(essentials::AgentID::MAX_SIZE));
+    ASSERT_NE(0, memcmp(id->getRaw(), id->getRaw() + 16, 16));
+    ASSERT_THROW(factory.generateID(essentials::AgentID::MAX_SIZE + 1), std::length_error);
+}
+
 TEST(AgentIDManager, CreateIDsFromIntegralTypes)
 {
     essentials::AgentIDFactory* factory = new essentials::AgentIDFactory();
@@ -183,6 +261,240 @@ TEST(AgentIDManager, GuarenteeSingleEntities)
     ASSERT_EQ(intId1, intId2);
 }
 
+TEST(AgentIDManager, ConcurrentLookups)
+{
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory());
+    const int count = 1000;
+    std::vector<std::vector<const essentials::AgentID*>> results(4, std::vector<const essentials::AgentID*>(count));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < results.size(); t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < count; i++) {
+                results[t][i] = idManager.getID<int>(i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(results[0][i], idManager.getID<int>(i));
+        for (size_t t = 1; t < results.size(); t++) {
+            ASSERT_EQ(results[0][i], results[t][i]);
+        }
+    }
+    ASSERT_NE(results[0][1], results[0][2]);
+}
+
+TEST(AgentIDManager, DenseHandles)
+{
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory());
+    for (int i = 0; i < 100; i++) {
+        auto id = idManager.getID<int>(i);
+        ASSERT_EQ(static_cast<uint32_t>(i), id->getHandle());
+        ASSERT_EQ(id, idManager.getIDFromHandle(id->getHandle()));
+    }
+    auto generated = idManager.generateID();
+    ASSERT_EQ(100u, generated->getHandle());
+    ASSERT_EQ(101u, idManager.getIDCount());
+    ASSERT_EQ(nullptr, idManager.getIDFromHandle(101));
+
+    // copies keep the handle, but it is no part of the value
+    essentials::AgentID copy = *generated;
+    ASSERT_EQ(generated->getHandle(), copy.getHandle());
+    essentials::AgentID uninterned(generated->getRaw(), generated->getSize());
+    ASSERT_EQ(essentials::AgentID::NO_HANDLE, uninterned.getHandle());
+    ASSERT_TRUE(uninterned == *generated);
+    int one = 1;
+    ASSERT_TRUE(essentials::AgentIDHandleComparator()(idManager.getID<int>(one), generated));
+}
+
+TEST(AgentIDManager, OversizedIDsTakeNoHandle)
+{
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory(), true);
+    int one = 1;
+    {
+        essentials::AgentIDRef ref = idManager.acquireID<int>(one);
+        ASSERT_EQ(0u, ref->getHandle());
+    }
+    std::vector<uint8_t> bytes(essentials::AgentID::MAX_SIZE + 1, 1);
+    ASSERT_THROW(idManager.getIDFromBytes(bytes), std::length_error);
+    ASSERT_THROW(idManager.acquireIDFromBytes(bytes), std::length_error);
+    // the handle of the released ID is still free
+    int two = 2;
+    ASSERT_EQ(0u, idManager.getID<int>(two)->getHandle());
+    ASSERT_EQ(1u, idManager.getIDCount());
+}
+
+TEST(AgentIDManager, FindDoesNotIntern)
+{
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory());
+    int known = 1;
+    int unknown = 2;
+    auto id = idManager.getID<int>(known);
+    ASSERT_EQ(id, idManager.findIDFromBytes(reinterpret_cast<uint8_t*>(&known), sizeof(known)));
+    ASSERT_EQ(nullptr, idManager.findIDFromBytes(reinterpret_cast<uint8_t*>(&unknown), sizeof(unknown)));
+    ASSERT_EQ(nullptr, idManager.findIDFromBytes(nullptr, 0));
+    ASSERT_EQ(1u, idManager.getIDCount());
+}
+
+TEST(AgentIDManager, ReclaimsUnusedIDs)
+{
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory(), true);
+    int pinnedValue = -1;
+    auto pinned = idManager.getID<int>(pinnedValue);
+    for (int i = 0; i < 100000; i++) {
+        essentials::AgentIDRef ref = idManager.acquireID<int>(i);
+        essentials::AgentIDRef copy = ref;
+        ASSERT_EQ(ref.get(), idManager.acquireID<int>(i).get());
+        ASSERT_EQ(ref.get(), idManager.getIDFromHandle(copy->getHandle()));
+    }
+    // freed handles are reused, so the count stays flat
+    ASSERT_LT(idManager.getIDCount(), 8u);
+    ASSERT_EQ(pinned, idManager.getID<int>(pinnedValue));
+
+    // getID pins an ID, which has been acquired before
+    int value = 7;
+    const essentials::AgentID* id = idManager.acquireID<int>(value).get();
+    ASSERT_EQ(id, idManager.getID<int>(value));
+    {
+        essentials::AgentIDRef ref = idManager.acquireID<int>(value);
+    }
+    ASSERT_EQ(id, idManager.getID<int>(value));
+}
+
+TEST(SharedAgentIDRegistry, SharesIDsAndHandles)
+{
+    std::string name = "/agent_id_test_" + std::to_string(getpid());
+    essentials::SharedAgentIDRegistry::remove(name);
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory(), new essentials::SharedAgentIDRegistry(name, 1000));
+    // a second mapping of the same segment stands in for another process
+    essentials::SharedAgentIDRegistry other(name);
+    ASSERT_EQ(1000u, other.getMaxIDs());
+
+    for (int i = 0; i < 100; i++) {
+        auto id = idManager.getID<int>(i);
+        ASSERT_EQ(static_cast<uint32_t>(i), id->getHandle());
+        auto otherID = other.getIDFromHandle(id->getHandle());
+        ASSERT_NE(id, otherID);
+        ASSERT_TRUE(*id == *otherID);
+        ASSERT_EQ(otherID, other.getIDFromBytes(id->getRaw(), id->getSize()));
+    }
+    int value = 1000;
+    auto otherID = other.getIDFromBytes(reinterpret_cast<uint8_t*>(&value), sizeof(value));
+    ASSERT_EQ(100u, otherID->getHandle());
+    int unknown = 3000;
+    ASSERT_EQ(nullptr, idManager.findIDFromBytes(reinterpret_cast<uint8_t*>(&unknown), sizeof(unknown)));
+    ASSERT_EQ(101u, idManager.getIDCount());
+    ASSERT_EQ(100u, idManager.findIDFromBytes(reinterpret_cast<uint8_t*>(&value), sizeof(value))->getHandle());
+    ASSERT_EQ(idManager.getIDFromHandle(100), idManager.getID<int>(value));
+
+    // handles are consistent across processes
+    pid_t child = fork();
+    if (child == 0) {
+        essentials::SharedAgentIDRegistry registry(name);
+        int childValue = 2000;
+        auto id = registry.getIDFromBytes(reinterpret_cast<uint8_t*>(&childValue), sizeof(childValue));
+        _exit(id->getHandle() == 101 && registry.getIDFromHandle(5)->getRaw()[0] == 5 ? 0 : 1);
+    }
+    int status;
+    ASSERT_EQ(child, waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+    int childValue = 2000;
+    ASSERT_EQ(101u, idManager.getID<int>(childValue)->getHandle());
+
+    ASSERT_TRUE(essentials::SharedAgentIDRegistry::remove(name));
+}
+
+TEST(SharedAgentIDRegistry, FallsBackToLocalIDsWhenFull)
+{
+    std::string name = "/agent_id_test_full_" + std::to_string(getpid());
+    essentials::SharedAgentIDRegistry::remove(name);
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory(), new essentials::SharedAgentIDRegistry(name, 2));
+    essentials::SharedAgentIDRegistry other(name);
+
+    int values[] = {1, 2, 3, 4};
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(static_cast<uint32_t>(i), idManager.getID<int>(values[i])->getHandle());
+    }
+    ASSERT_THROW(other.getIDFromBytes(reinterpret_cast<uint8_t*>(&values[2]), sizeof(int)), std::length_error);
+
+    // the manager keeps working with IDs of its own
+    auto local = idManager.getID<int>(values[2]);
+    ASSERT_NE(nullptr, local);
+    ASSERT_EQ(2u, local->getHandle());
+    ASSERT_EQ(3u, idManager.getIDCount());
+    ASSERT_EQ(local, idManager.getID<int>(values[2]));
+    ASSERT_EQ(local, idManager.getIDFromHandle(2));
+    ASSERT_EQ(nullptr, idManager.getIDFromHandle(3));
+    ASSERT_EQ(3u, idManager.getID<int>(values[3])->getHandle());
+    ASSERT_EQ(4u, idManager.getIDCount());
+    ASSERT_EQ(idManager.getID<int>(values[0]), idManager.getIDFromHandle(0));
+    ASSERT_EQ(2u, other.getIDCount());
+
+    ASSERT_TRUE(essentials::SharedAgentIDRegistry::remove(name));
+}
+
+TEST(SharedAgentIDRegistry, RejectsCorruptedSegments)
+{
+    std::string name = "/agent_id_test_corrupt_" + std::to_string(getpid());
+    essentials::SharedAgentIDRegistry::remove(name);
+    essentials::SharedAgentIDRegistry registry(name, 1);
+    int value = 1;
+    ASSERT_NE(nullptr, registry.getIDFromBytes(reinterpret_cast<uint8_t*>(&value), sizeof(value)));
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    ASSERT_LE(0, fd);
+    struct stat status;
+    ASSERT_EQ(0, fstat(fd, &status));
+    ASSERT_EQ(0600u, status.st_mode & 0777);
+    void* segment = mmap(nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(MAP_FAILED, segment);
+    // the 64 slots of a registry for one ID end, where its only ID starts
+    uint32_t* slots = reinterpret_cast<uint32_t*>(static_cast<char*>(segment) + status.st_size - sizeof(essentials::AgentID)) - 64;
+    for (int i = 0; i < 64; i++) {
+        slots[i] = 0x7fffffff;
+    }
+    ASSERT_THROW(registry.getIDFromBytes(reinterpret_cast<uint8_t*>(&value), sizeof(value)), std::runtime_error);
+    ASSERT_THROW(registry.findID(reinterpret_cast<uint8_t*>(&value), sizeof(value)), std::runtime_error);
+    munmap(segment, status.st_size);
+
+    ASSERT_TRUE(essentials::SharedAgentIDRegistry::remove(name));
+}
+
+TEST(AgentIDManager, ConcurrentAcquireAndRelease)
+{
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory(), true);
+    const int count = 64;
+    std::vector<std::thread> threads;
+    std::atomic<int> mismatches(0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < 2000; round++) {
+                int value = (round * 7 + t) % count;
+                essentials::AgentIDRef ref = idManager.acquireID<int>(value);
+                int stored;
+                memcpy(&stored, ref->getRaw(), sizeof(stored));
+                if (stored != value || ref.get() != idManager.acquireID<int>(value).get()) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0, mismatches.load());
+    // a preempted lookup delays the reclamation, but once it is over, the freed handles are reused
+    uint32_t idCount = idManager.getIDCount();
+    for (int i = count; i < 10 * count; i++) {
+        idManager.acquireID<int>(i);
+    }
+    ASSERT_LE(idManager.getIDCount(), idCount + 2);
+}
+
 TEST(AgentIDManager, GenerateIDsOfVariousLength)
 {
     essentials::AgentIDFactory* factory = new essentials::AgentIDFactory();
@@ -201,6 +513,76 @@ TEST(AgentIDManager, GenerateIDsOfVariousLength)
     ASSERT_EQ(id18->getSize(), 18);
 }
 
+TEST(AgentIDCodec, RoundTrip)
+{
+    essentials::AgentIDManager idManager(new essentials::AgentIDFactory());
+    std::vector<const essentials::AgentID*> ids;
+    int values[] = {0, 9, -1, 300, 9, 0x7fffffff};
+    for (int& value : values) {
+        ids.push_back(idManager.getID<int>(value));
+    }
+    auto uuid = idManager.generateID(16);
+    essentials::AgentID broadcast = essentials::AgentID::broadcast();
+    ids.push_back(uuid);
+    ids.push_back(&broadcast);
+    ids.push_back(uuid);
+
+    std::vector<uint8_t> packed;
+    essentials::AgentIDCodec::encode(ids, packed);
+    // count, 2 bytes per small int, 1 byte per repetition, tag + size + bytes for the UUID, 1 byte for the broadcast
+    ASSERT_EQ(1u + 2 + 2 + 2 + 3 + 1 + 6 + 18 + 1 + 1, packed.size());
+
+    std::vector<essentials::AgentID> decoded;
+    essentials::AgentIDCodec::decode(packed, decoded);
+    ASSERT_EQ(ids.size(), decoded.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        ASSERT_TRUE(*ids[i] == decoded[i]);
+        ASSERT_EQ(ids[i]->getType(), decoded[i].getType());
+        ASSERT_EQ(essentials::AgentID::NO_HANDLE, decoded[i].getHandle());
+    }
+
+    std::vector<const essentials::AgentID*> interned;
+    essentials::AgentIDCodec::decode(packed.data(), packed.size(), &idManager, interned);
+    ASSERT_EQ(ids.size(), interned.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        ASSERT_EQ(ids[i]->isBroadcast() ? nullptr : ids[i], interned[i]);
+    }
+}
+
+TEST(AgentIDCodec, KeepsTypesOfEqualBytes)
+{
+    int value = 7;
+    essentials::AgentID intID(reinterpret_cast<uint8_t*>(&value), sizeof(value), essentials::AgentID::INT_TYPE);
+    essentials::AgentID uuidID(reinterpret_cast<uint8_t*>(&value), sizeof(value), essentials::AgentID::UUID_TYPE);
+    std::vector<const essentials::AgentID*> ids = {&intID, &uuidID, &intID};
+    std::vector<uint8_t> packed;
+    essentials::AgentIDCodec::encode(ids, packed);
+
+    std::vector<essentials::AgentID> decoded;
+    essentials::AgentIDCodec::decode(packed, decoded);
+    ASSERT_EQ(3u, decoded.size());
+    ASSERT_EQ(essentials::AgentID::INT_TYPE, decoded[0].getType());
+    ASSERT_EQ(essentials::AgentID::UUID_TYPE, decoded[1].getType());
+    ASSERT_EQ(essentials::AgentID::INT_TYPE, decoded[2].getType());
+
+    ids.push_back(nullptr);
+    packed.clear();
+    ASSERT_THROW(essentials::AgentIDCodec::encode(ids, packed), std::invalid_argument);
+}
+
+TEST(AgentIDCodec, RejectsMalformedData)
+{
+    std::vector<essentials::AgentID> decoded;
+    // truncated varint, too many IDs, forward reference, oversized raw ID
+    std::vector<std::vector<uint8_t>> malformed = {{0x80}, {5, 1}, {2, 3, 3}, {1, 0, 33}};
+    for (auto& data : malformed) {
+        ASSERT_THROW(essentials::AgentIDCodec::decode(data, decoded), std::runtime_error);
+    }
+    std::vector<uint8_t> empty = {0};
+    essentials::AgentIDCodec::decode(empty, decoded);
+    ASSERT_TRUE(decoded.empty());
+}
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);
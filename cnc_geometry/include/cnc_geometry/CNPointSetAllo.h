@@ -0,0 +1,25 @@
+#pragma once
+
+#include "cnc_geometry/CNPointSetTemplate.h"
+#include "cnc_geometry/CNPointAllo.h"
+
+namespace geometry
+{
+
+class CNPointSetEgo;
+class CNPositionAllo;
+
+class CNPointSetAllo : public CNPointSetTemplate<CNPointAllo>
+{
+public:
+    CNPointSetAllo() {}
+    explicit CNPointSetAllo(const std::vector<CNPointAllo>& points)
+            : CNPointSetTemplate<CNPointAllo>(points)
+    {
+    }
+
+    CNPointSetEgo toEgo(const CNPositionAllo& me) const;
+    void toEgo(const CNPositionAllo& me, CNPointSetEgo& ego) const;
+};
+
+} /* namespace geometry */
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "cnc_geometry/CNPointSetTemplate.h"
+#include "cnc_geometry/CNPointEgo.h"
+
+namespace geometry
+{
+
+class CNPointSetAllo;
+class CNPositionAllo;
+
+class CNPointSetEgo : public CNPointSetTemplate<CNPointEgo>
+{
+public:
+    CNPointSetEgo() {}
+    explicit CNPointSetEgo(const std::vector<CNPointEgo>& points)
+            : CNPointSetTemplate<CNPointEgo>(points)
+    {
+    }
+
+    CNPointSetAllo toAllo(const CNPositionAllo& me) const;
+    void toAllo(const CNPositionAllo& me, CNPointSetAllo& allo) const;
+};
+
+} /* namespace geometry */
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace geometry
+{
+
+/**
+ * A set of points stored as structure of arrays, i.e., one contiguous array per coordinate,
+ * so that transformations can process several points per instruction.
+ */
+template <class T>
+class CNPointSetTemplate
+{
+public:
+    CNPointSetTemplate() {}
+
+    explicit CNPointSetTemplate(const std::vector<T>& points)
+    {
+        this->reserve(points.size());
+        for (const T& point : points) {
+            this->push_back(point);
+        }
+    }
+
+    size_t size() const { return this->xs.size(); }
+    bool empty() const { return this->xs.empty(); }
+
+    void reserve(size_t count)
+    {
+        this->xs.reserve(count);
+        this->ys.reserve(count);
+        this->zs.reserve(count);
+    }
+
+    void resize(size_t count)
+    {
+        this->xs.resize(count);
+        this->ys.resize(count);
+        this->zs.resize(count);
+    }
+
+    void clear()
+    {
+        this->xs.clear();
+        this->ys.clear();
+        this->zs.clear();
+    }
+
+    void push_back(const T& point)
+    {
+        this->xs.push_back(point.x);
+        this->ys.push_back(point.y);
+        this->zs.push_back(point.z);
+    }
+
+    T at(size_t i) const { return T(this->xs.at(i), this->ys.at(i), this->zs.at(i)); }
+
+    std::vector<T> toVector() const
+    {
+        std::vector<T> points;
+        points.reserve(this->size());
+        for (size_t i = 0; i < this->size(); i++) {
+            points.push_back(T(this->xs[i], this->ys[i], this->zs[i]));
+        }
+        return points;
+    }
+
+    const double* getX() const { return this->xs.data(); }
+    const double* getY() const { return this->ys.data(); }
+    const double* getZ() const { return this->zs.data(); }
+    double* getX() { return this->xs.data(); }
+    double* getY() { return this->ys.data(); }
+    double* getZ() { return this->zs.data(); }
+
+protected:
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> zs;
+};
+
+} /* namespace geometry */
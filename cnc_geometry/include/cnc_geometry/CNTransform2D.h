@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+
+namespace geometry
+{
+
+class CNPositionAllo;
+
+/**
+ * A rotation around the z axis followed by a translation in the xy plane, i.e.,
+ * out = R(angle) * in + (tx, ty). Sine and cosine are computed once, so applying it
+ * to many points costs a few multiplications and additions per point.
+ */
+class CNTransform2D
+{
+public:
+    CNTransform2D(double angle, double tx, double ty);
+
+    /**
+     * The transformation of allocentric coordinates into the egocentric frame of the given position.
+     */
+    static CNTransform2D alloToEgo(const CNPositionAllo& me);
+
+    /**
+     * The transformation of egocentric coordinates of the given position into allocentric ones.
+     */
+    static CNTransform2D egoToAllo(const CNPositionAllo& me);
+
+    void apply(double x, double y, double& xOut, double& yOut) const;
+
+    /**
+     * Transforms count points given as separate coordinate arrays, with AVX or SSE2 if the
+     * compiler targets them. The output arrays may be the input arrays.
+     */
+    void apply(const double* xIn, const double* yIn, double* xOut, double* yOut, size_t count) const;
+
+private:
+    double cos;
+    double sin;
+    double tx;
+    double ty;
+};
+
+} /* namespace geometry */
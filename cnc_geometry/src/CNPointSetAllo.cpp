@@ -0,0 +1,32 @@
+#include "cnc_geometry/CNPointSetAllo.h"
+
+#include "cnc_geometry/CNPointSetEgo.h"
+#include "cnc_geometry/CNPositionAllo.h"
+#include "cnc_geometry/CNTransform2D.h"
+
+#include <algorithm>
+
+namespace geometry
+{
+
+CNPointSetEgo CNPointSetAllo::toEgo(const CNPositionAllo& me) const
+{
+    CNPointSetEgo ego;
+    this->toEgo(me, ego);
+    return ego;
+}
+
+/**
+ * Converts all points into egocentric points with respect to the given allocentric position,
+ * like CNPointAllo::toEgo does for single points.
+ * @param me the allocentric reference position
+ * @param ego is resized to this set, so its memory can be reused from frame to frame
+ */
+void CNPointSetAllo::toEgo(const CNPositionAllo& me, CNPointSetEgo& ego) const
+{
+    ego.resize(this->size());
+    CNTransform2D::alloToEgo(me).apply(this->getX(), this->getY(), ego.getX(), ego.getY(), this->size());
+    std::copy(this->zs.begin(), this->zs.end(), ego.getZ());
+}
+
+} /* namespace geometry */
@@ -0,0 +1,31 @@
+#include "cnc_geometry/CNPointSetEgo.h"
+
+#include "cnc_geometry/CNPointSetAllo.h"
+#include "cnc_geometry/CNPositionAllo.h"
+#include "cnc_geometry/CNTransform2D.h"
+
+#include <algorithm>
+
+namespace geometry
+{
+
+CNPointSetAllo CNPointSetEgo::toAllo(const CNPositionAllo& me) const
+{
+    CNPointSetAllo allo;
+    this->toAllo(me, allo);
+    return allo;
+}
+
+/**
+ * Converts all points into allocentric points, like CNPointEgo::toAllo does for single points.
+ * @param me the allocentric position, which is the origin of these points
+ * @param allo is resized to this set, so its memory can be reused from frame to frame
+ */
+void CNPointSetEgo::toAllo(const CNPositionAllo& me, CNPointSetAllo& allo) const
+{
+    allo.resize(this->size());
+    CNTransform2D::egoToAllo(me).apply(this->getX(), this->getY(), allo.getX(), allo.getY(), this->size());
+    std::copy(this->zs.begin(), this->zs.end(), allo.getZ());
+}
+
+} /* namespace geometry */
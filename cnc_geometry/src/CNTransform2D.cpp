@@ -0,0 +1,82 @@
+#include "cnc_geometry/CNTransform2D.h"
+
+#include "cnc_geometry/CNPositionAllo.h"
+
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace geometry
+{
+
+CNTransform2D::CNTransform2D(double angle, double tx, double ty)
+        : cos(std::cos(angle))
+        , sin(std::sin(angle))
+        , tx(tx)
+        , ty(ty)
+{
+}
+
+CNTransform2D CNTransform2D::alloToEgo(const CNPositionAllo& me)
+{
+    // rotate by -theta after subtracting me, so the translation is -R(-theta) * me
+    double c = std::cos(me.theta);
+    double s = std::sin(me.theta);
+    return CNTransform2D(-me.theta, -(c * me.x + s * me.y), s * me.x - c * me.y);
+}
+
+CNTransform2D CNTransform2D::egoToAllo(const CNPositionAllo& me)
+{
+    return CNTransform2D(me.theta, me.x, me.y);
+}
+
+void CNTransform2D::apply(double x, double y, double& xOut, double& yOut) const
+{
+    xOut = this->cos * x - this->sin * y + this->tx;
+    yOut = this->sin * x + this->cos * y + this->ty;
+}
+
+void CNTransform2D::apply(const double* xIn, const double* yIn, double* xOut, double* yOut, size_t count) const
+{
+    size_t i = 0;
+#ifdef __AVX__
+    const __m256d c4 = _mm256_set1_pd(this->cos);
+    const __m256d s4 = _mm256_set1_pd(this->sin);
+    const __m256d tx4 = _mm256_set1_pd(this->tx);
+    const __m256d ty4 = _mm256_set1_pd(this->ty);
+    for (; i + 4 <= count; i += 4) {
+        __m256d x = _mm256_loadu_pd(xIn + i);
+        __m256d y = _mm256_loadu_pd(yIn + i);
+#ifdef __FMA__
+        __m256d xNew = _mm256_fmadd_pd(c4, x, _mm256_fnmadd_pd(s4, y, tx4));
+        __m256d yNew = _mm256_fmadd_pd(s4, x, _mm256_fmadd_pd(c4, y, ty4));
+#else
+        __m256d xNew = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(c4, x), _mm256_mul_pd(s4, y)), tx4);
+        __m256d yNew = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(s4, x), _mm256_mul_pd(c4, y)), ty4);
+#endif
+        _mm256_storeu_pd(xOut + i, xNew);
+        _mm256_storeu_pd(yOut + i, yNew);
+    }
+#endif
+#ifdef __SSE2__
+    const __m128d c2 = _mm_set1_pd(this->cos);
+    const __m128d s2 = _mm_set1_pd(this->sin);
+    const __m128d tx2 = _mm_set1_pd(this->tx);
+    const __m128d ty2 = _mm_set1_pd(this->ty);
+    for (; i + 2 <= count; i += 2) {
+        __m128d x = _mm_loadu_pd(xIn + i);
+        __m128d y = _mm_loadu_pd(yIn + i);
+        __m128d xNew = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(c2, x), _mm_mul_pd(s2, y)), tx2);
+        __m128d yNew = _mm_add_pd(_mm_add_pd(_mm_mul_pd(s2, x), _mm_mul_pd(c2, y)), ty2);
+        _mm_storeu_pd(xOut + i, xNew);
+        _mm_storeu_pd(yOut + i, yNew);
+    }
+#endif
+    for (; i < count; i++) {
+        this->apply(xIn[i], yIn[i], xOut[i], yOut[i]);
+    }
+}
+
+} /* namespace geometry */
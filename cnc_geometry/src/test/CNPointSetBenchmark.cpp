@@ -0,0 +1,96 @@
+#include "cnc_geometry/CNPointAllo.h"
+#include "cnc_geometry/CNPointEgo.h"
+#include "cnc_geometry/CNPointSetAllo.h"
+#include "cnc_geometry/CNPointSetEgo.h"
+#include "cnc_geometry/CNPositionAllo.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+
+std::vector<geometry::CNPointAllo> createPoints(int count)
+{
+    std::mt19937_64 generator(13);
+    std::uniform_real_distribution<double> coordinate(-9000, 9000);
+    std::vector<geometry::CNPointAllo> points;
+    for (int i = 0; i < count; i++) {
+        points.push_back(geometry::CNPointAllo(coordinate(generator), coordinate(generator), coordinate(generator)));
+    }
+    return points;
+}
+
+geometry::CNPositionAllo me(1234.5, -678.9, 2.1);
+
+void BM_PointAlloToEgo(benchmark::State& state)
+{
+    std::vector<geometry::CNPointAllo> points = createPoints(state.range(0));
+    std::vector<geometry::CNPointEgo> ego(points.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < points.size(); i++) {
+            ego[i] = points[i].toEgo(me);
+        }
+        benchmark::DoNotOptimize(ego.data());
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+void BM_PointSetAlloToEgo(benchmark::State& state)
+{
+    geometry::CNPointSetAllo points(createPoints(state.range(0)));
+    geometry::CNPointSetEgo ego;
+    for (auto _ : state) {
+        points.toEgo(me, ego);
+        benchmark::DoNotOptimize(ego.getX());
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+/**
+ * Includes the conversions from and to vectors of points, as done by callers that keep them.
+ */
+void BM_PointSetAlloToEgoFromVector(benchmark::State& state)
+{
+    std::vector<geometry::CNPointAllo> points = createPoints(state.range(0));
+    for (auto _ : state) {
+        std::vector<geometry::CNPointEgo> ego = geometry::CNPointSetAllo(points).toEgo(me).toVector();
+        benchmark::DoNotOptimize(ego.data());
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+void BM_PointEgoToAllo(benchmark::State& state)
+{
+    std::vector<geometry::CNPointEgo> points = geometry::CNPointSetAllo(createPoints(state.range(0))).toEgo(me).toVector();
+    std::vector<geometry::CNPointAllo> allo(points.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < points.size(); i++) {
+            allo[i] = points[i].toAllo(me);
+        }
+        benchmark::DoNotOptimize(allo.data());
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+void BM_PointSetEgoToAllo(benchmark::State& state)
+{
+    geometry::CNPointSetEgo points = geometry::CNPointSetAllo(createPoints(state.range(0))).toEgo(me);
+    geometry::CNPointSetAllo allo;
+    for (auto _ : state) {
+        points.toAllo(me, allo);
+        benchmark::DoNotOptimize(allo.getX());
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+} // namespace
+
+BENCHMARK(BM_PointAlloToEgo)->Range(16, 1024);
+BENCHMARK(BM_PointSetAlloToEgo)->Range(16, 1024);
+BENCHMARK(BM_PointSetAlloToEgoFromVector)->Range(16, 1024);
+BENCHMARK(BM_PointEgoToAllo)->Range(16, 1024);
+BENCHMARK(BM_PointSetEgoToAllo)->Range(16, 1024);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,116 @@
+#include "cnc_geometry/CNPointAllo.h"
+#include "cnc_geometry/CNPointEgo.h"
+#include "cnc_geometry/CNPointSetAllo.h"
+#include "cnc_geometry/CNPointSetEgo.h"
+#include "cnc_geometry/CNPositionAllo.h"
+#include "cnc_geometry/CNTransform2D.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+// FMA rounds differently than the scalar code, so the coordinates are compared with a tolerance
+const double EPSILON = 1e-9;
+
+/**
+ * Sizes 0 to 9 run through the AVX, SSE2 and scalar remainder loops in every combination.
+ */
+const size_t MAX_SIZE = 10;
+
+std::vector<geometry::CNPointAllo> createPoints(size_t count)
+{
+    std::mt19937_64 generator(count);
+    std::uniform_real_distribution<double> coordinate(-9000, 9000);
+    std::vector<geometry::CNPointAllo> points;
+    for (size_t i = 0; i < count; i++) {
+        points.push_back(geometry::CNPointAllo(coordinate(generator), coordinate(generator), coordinate(generator)));
+    }
+    return points;
+}
+
+geometry::CNPositionAllo me(1234.5, -678.9, 2.1);
+
+} // namespace
+
+TEST(CNPointSetAllo, ToEgoMatchesSinglePoints)
+{
+    for (size_t size = 0; size < MAX_SIZE; size++) {
+        std::vector<geometry::CNPointAllo> points = createPoints(size);
+        std::vector<geometry::CNPointEgo> ego = geometry::CNPointSetAllo(points).toEgo(me).toVector();
+
+        ASSERT_EQ(size, ego.size());
+        for (size_t i = 0; i < size; i++) {
+            geometry::CNPointEgo expected = points[i].toEgo(me);
+            EXPECT_NEAR(expected.x, ego[i].x, EPSILON) << "size " << size << ", point " << i;
+            EXPECT_NEAR(expected.y, ego[i].y, EPSILON) << "size " << size << ", point " << i;
+            EXPECT_EQ(expected.z, ego[i].z) << "size " << size << ", point " << i;
+        }
+    }
+}
+
+TEST(CNPointSetEgo, ToAlloMatchesSinglePoints)
+{
+    for (size_t size = 0; size < MAX_SIZE; size++) {
+        std::vector<geometry::CNPointEgo> points;
+        for (const geometry::CNPointAllo& point : createPoints(size)) {
+            points.push_back(geometry::CNPointEgo(point.x, point.y, point.z));
+        }
+        std::vector<geometry::CNPointAllo> allo = geometry::CNPointSetEgo(points).toAllo(me).toVector();
+
+        ASSERT_EQ(size, allo.size());
+        for (size_t i = 0; i < size; i++) {
+            geometry::CNPointAllo expected = points[i].toAllo(me);
+            EXPECT_NEAR(expected.x, allo[i].x, EPSILON) << "size " << size << ", point " << i;
+            EXPECT_NEAR(expected.y, allo[i].y, EPSILON) << "size " << size << ", point " << i;
+            EXPECT_EQ(expected.z, allo[i].z) << "size " << size << ", point " << i;
+        }
+    }
+}
+
+TEST(CNPointSetAllo, RoundTripRestoresPoints)
+{
+    geometry::CNPointSetEgo ego;
+    geometry::CNPointSetAllo allo;
+    // the output sets are reused, so they shrink and grow between the sizes
+    for (size_t size : {9, 0, 5, 1, 8, 2, 7, 3, 6, 4}) {
+        std::vector<geometry::CNPointAllo> points = createPoints(size);
+        geometry::CNPointSetAllo(points).toEgo(me, ego);
+        ego.toAllo(me, allo);
+        std::vector<geometry::CNPointAllo> restored = allo.toVector();
+
+        ASSERT_EQ(size, restored.size());
+        for (size_t i = 0; i < size; i++) {
+            EXPECT_NEAR(points[i].x, restored[i].x, 1e-6) << "size " << size << ", point " << i;
+            EXPECT_NEAR(points[i].y, restored[i].y, 1e-6) << "size " << size << ", point " << i;
+            EXPECT_EQ(points[i].z, restored[i].z) << "size " << size << ", point " << i;
+        }
+    }
+}
+
+TEST(CNTransform2D, AppliesInPlace)
+{
+    geometry::CNTransform2D transform = geometry::CNTransform2D::alloToEgo(me);
+    for (size_t size = 0; size < MAX_SIZE; size++) {
+        geometry::CNPointSetAllo points(createPoints(size));
+        std::vector<double> xs(points.getX(), points.getX() + size);
+        std::vector<double> ys(points.getY(), points.getY() + size);
+        transform.apply(xs.data(), ys.data(), xs.data(), ys.data(), size);
+
+        for (size_t i = 0; i < size; i++) {
+            double x;
+            double y;
+            transform.apply(points.getX()[i], points.getY()[i], x, y);
+            EXPECT_NEAR(x, xs[i], EPSILON) << "size " << size << ", point " << i;
+            EXPECT_NEAR(y, ys[i], EPSILON) << "size " << size << ", point " << i;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
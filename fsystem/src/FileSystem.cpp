@@ -150,7 +150,7 @@ std::vector<std::string> FileSystem::findAllFiles(std::string path, std::string
         std::string curFile = namelist[i]->d_name;
         std::string curFullFile = combinePaths(path, curFile);
         if (isDirectory(curFullFile)) {
-            continue;
+            // directories are not searched
         } else if (isFile(curFullFile)) {
             if (hasSuffix(namelist[i]->d_name, ending)) {
                 files.push_back(curFullFile);
@@ -267,15 +267,6 @@ bool FileSystem::endsWith(const std::string& file, const char ending)
     return !file.empty() && (file[file.length() - 1] == ending);
 }
 
-bool FileSystem::endsWith(const std::string& file, const char ending)
-{
-    if (!file.empty() && (file[file.length() - 1] == ending)) {
-        return true;
-    } else {
-        return false;
-    }
-}
-
 /**
  * Determines the parent folder of the given path.
  * @param path
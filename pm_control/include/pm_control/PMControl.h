@@ -62,7 +62,7 @@ private:
 
     essentials::SystemConfig* sc;
 
-    std::map<const essentials::AgentID*, pm_widget::ControlledProcessManager*, essentials::AgentIDComparator> processManagersMap;
+    std::map<const essentials::AgentID*, pm_widget::ControlledProcessManager*, essentials::AgentIDHandleComparator> processManagersMap;
 
     void handleProcessStats();
 
@@ -48,7 +48,7 @@ public:
     essentials::RobotExecutableRegistry* pmRegistry;
 
 private:
-    std::map<const essentials::AgentID*, ControlledRobot*, essentials::AgentIDComparator>
+    std::map<const essentials::AgentID*, ControlledRobot*, essentials::AgentIDHandleComparator>
             controlledRobotsMap; /* < The robots, which are controlled by this process manager */
     QBoxLayout* parentLayout;
     ControlledRobot* getControlledRobot(const essentials::AgentID* robotId);
@@ -128,6 +128,9 @@ void PMControl::handleProcessStats()
 pm_widget::ControlledProcessManager* PMControl::getControlledProcessManager(const vector<uint8_t>& processManagerId)
 {
     const essentials::AgentID* id = this->pmRegistry->getRobotId(processManagerId);
+    if (id == nullptr) { // empty or oversized ID
+        return nullptr;
+    }
     string pmName;
     auto pmEntry = this->processManagersMap.find(id);
     if (pmEntry != this->processManagersMap.end()) { // process manager is already known
@@ -1,4 +1,5 @@
 #include <SystemConfig.h>
+#include <essentials/AgentIDCodec.h>
 #include <process_manager/RobotExecutableRegistry.h>
 
 #include "pm_widget/ControlledProcessManager.h"
@@ -32,9 +33,28 @@ ControlledProcessManager::~ControlledProcessManager()
 void ControlledProcessManager::handleProcessStats(std::pair<std::chrono::system_clock::time_point, process_manager::ProcessStatsConstPtr> timePstsPair)
 {
     this->timeLastMsgReceived = timePstsPair.first;
-    for (auto& processStat : timePstsPair.second->process_stats) {
+    const process_manager::ProcessStats& psts = *timePstsPair.second;
+    std::vector<essentials::AgentID> robotIDs;
+    if (!psts.robot_ids_packed.empty()) {
+        try {
+            essentials::AgentIDCodec::decode(psts.robot_ids_packed, robotIDs);
+        } catch (const std::exception& e) {
+            std::cerr << "ControlledPM: Received malformed process stats! " << e.what() << std::endl;
+            return;
+        }
+        if (robotIDs.size() != psts.process_stats.size()) {
+            std::cerr << "ControlledPM: Received malformed process stats! #RobotIDs != #ProcessStats" << std::endl;
+            return;
+        }
+    }
+    for (size_t i = 0; i < psts.process_stats.size(); i++) {
+        auto& processStat = psts.process_stats[i];
         // get the corresponding controlled robot
-        auto agentID = this->pmRegistry->getRobotId(processStat.robot_id.id);
+        auto agentID = robotIDs.empty() ? this->pmRegistry->getRobotId(processStat.robot_id.id)
+                                        : this->pmRegistry->getRobotId(robotIDs[i].getRaw(), robotIDs[i].getSize());
+        if (agentID == nullptr) { // empty or oversized ID, already reported by the registry
+            continue;
+        }
         ControlledRobot* controlledRobot = this->getControlledRobot(agentID);
         if (controlledRobot != nullptr) {
             // call the controlled robot to update its corresponding process statistics.
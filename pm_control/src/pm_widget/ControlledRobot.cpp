@@ -6,7 +6,7 @@
 
 #include <SystemConfig.h>
 #include <essentials/AgentID.h>
-#include <essentials/BroadcastID.h>
+#include <essentials/AgentIDCodec.h>
 #include <process_manager/ExecutableMetaData.h>
 #include <process_manager/ProcessCommand.h>
 #include <process_manager/RobotExecutableRegistry.h>
@@ -25,7 +25,7 @@ ControlledRobot::ControlledRobot(string robotName, const essentials::AgentID* ro
     // setup gui stuff
     this->_robotProcessesWidget->setupUi(this->robotProcessesQFrame);
     auto pmRegistry = essentials::RobotExecutableRegistry::get();
-    if (dynamic_cast<const essentials::BroadcastID*>(parentPMid)) {
+    if (parentPMid != nullptr && parentPMid->isBroadcast()) {
         // don't show in robot_control
         this->_robotProcessesWidget->robotHostLabel->hide();
         this->inRobotControl = true;
@@ -121,7 +121,10 @@ void ControlledRobot::sendProcessCommand(vector<int> execIds, vector<int> paramS
     process_manager::ProcessCommand pc;
     pc.receiver_id.type = this->parentPMid->getType();
     pc.receiver_id.id = this->parentPMid->toByteVector();
+    essentials::AgentIDCodec::encode(&this->agentID, 1, pc.robot_ids_packed);
+    // still filled for process managers, which do not know robot_ids_packed yet
     pc.robot_ids.push_back(process_manager::ProcessCommand::_robot_ids_type::value_type());
+    pc.robot_ids[0].type = this->agentID->getType();
     pc.robot_ids[0].id = this->agentID->toByteVector();
     pc.process_keys = execIds;
     pc.param_sets = paramSets;
@@ -51,7 +51,7 @@ private:
     std::string ownHostname;
     const essentials::AgentID* ownId;
     bool simMode;
-    std::map<const essentials::AgentID*, ManagedRobot*, essentials::AgentIDComparator> robotMap;
+    std::map<const essentials::AgentID*, ManagedRobot*, essentials::AgentIDHandleComparator> robotMap;
     RobotExecutableRegistry* pmRegistry;
     std::vector<std::string> interpreters;
     unsigned long long lastTotalCPUTime;
@@ -69,6 +69,7 @@ private:
     void handleProcessCommand(process_manager::ProcessCommandPtr pc);
     void changeDesiredProcessStates(process_manager::ProcessCommandPtr pc, bool shouldRun);
     void changeLogPublishing(process_manager::ProcessCommandPtr pc, bool shouldPublish);
+    static std::vector<essentials::AgentID> getRobotIDs(process_manager::ProcessCommandPtr pc);
     std::thread* mainThread;
     std::chrono::microseconds iterationTime;
 
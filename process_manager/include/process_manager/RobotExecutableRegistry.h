@@ -8,6 +8,7 @@
 #include <map>
 #include <stdint.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace essentials
@@ -24,13 +25,15 @@ class RobotExecutableRegistry
 {
 public:
     static RobotExecutableRegistry* get();
-    const std::map<const essentials::AgentID*, RobotMetaData*, essentials::AgentIDComparator>& getRobots() const;
+    const std::map<const essentials::AgentID*, RobotMetaData*, essentials::AgentIDHandleComparator>& getRobots() const;
     void addRobot(std::string agentName, const essentials::AgentID* agentID);
     const essentials::AgentID* addRobot(std::string agentName);
     std::string addRobot(const essentials::AgentID* agentID);
     const essentials::AgentID* getRobotId(const std::string& agentName) const;
     const essentials::AgentID* getRobotId(const std::vector<uint8_t>& idVector);
     const essentials::AgentID* getRobotId(const std::vector<uint8_t>& idVector, std::string& robotName);
+    const essentials::AgentID* getRobotId(const uint8_t* idBytes, size_t idSize);
+    const essentials::AgentID* getRobotId(const uint8_t* idBytes, size_t idSize, std::string& robotName);
     bool getRobotName(const essentials::AgentID* agentID, std::string& robotName);
     bool robotExists(const essentials::AgentID* agentID);
     bool robotExists(std::string agentName);
@@ -52,7 +55,16 @@ private:
     RobotExecutableRegistry();
     virtual ~RobotExecutableRegistry();
 
-    std::map<const essentials::AgentID*, RobotMetaData*, essentials::AgentIDComparator> robotMap;
+    static essentials::AgentIDManager* createAgentIDManager(essentials::SystemConfig* sc);
+
+    const essentials::AgentID* intern(const essentials::AgentID* agentID);
+    const essentials::AgentID* lookup(const essentials::AgentID* agentID);
+    RobotMetaData* findRobot(const essentials::AgentID* agentID) const;
+    const essentials::AgentID* getValidID(const uint8_t* idBytes, size_t idSize);
+
+    std::map<const essentials::AgentID*, RobotMetaData*, essentials::AgentIDHandleComparator> robotMap;
+    std::vector<RobotMetaData*> robotsByHandle; /**< Same robots as robotMap, indexed by the handles of their IDs */
+    std::unordered_map<std::string, RobotMetaData*> robotsByName; /**< Same robots as robotMap, the first one added for each name */
     std::vector<ExecutableMetaData*> executableList;
     std::vector<std::string> interpreter;
     std::map<std::string, std::vector<std::pair<int, int>>> bundlesMap;
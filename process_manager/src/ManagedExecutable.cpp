@@ -202,10 +202,15 @@ void ManagedExecutable::update(unsigned long long cpuDelta)
     }
 }
 
+/**
+ * Adds the stats of the managed process. Its robot ID is also packed into psts.robot_ids_packed by the ProcessManager,
+ * but robot_id is still filled for receivers, which do not know the packed field yet.
+ */
 void ManagedExecutable::report(process_manager::ProcessStats& psts, const essentials::AgentID* agentID)
 {
     if (this->managedPid != ExecutableMetaData::NOTHING_MANAGED) {
         process_manager::ProcessStat ps;
+        ps.robot_id.type = agentID->getType();
         ps.robot_id.id = agentID->toByteVector();
         ps.cpu = this->cpu;
         ps.mem = this->memory * ManagedExecutable::kernelPageSize / 1024.0 / 1024.0; // MB
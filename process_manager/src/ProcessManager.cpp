@@ -5,7 +5,7 @@
 #include "process_manager/RobotExecutableRegistry.h"
 
 #include <Logging.h>
-#include <essentials/BroadcastID.h>
+#include <essentials/AgentIDCodec.h>
 
 #include <cstdlib>
 #include <dirent.h>
@@ -127,14 +127,11 @@ ProcessManager::~ProcessManager()
 void ProcessManager::handleProcessCommand(process_manager::ProcessCommandPtr pc)
 {
     // check whether this message is for me, 0 is a wild card for all ProcessManagers
-    const essentials::AgentID* receiverId = nullptr;
-    essentials::BroadcastID bcid(nullptr, 0);
     if (pc->receiver_id.type == essentials::AgentID::BC_TYPE) {
-        receiverId = &bcid;
-    } else {
-        receiverId = this->pmRegistry->getRobotId(pc->receiver_id.id);
-    }
-    if (receiverId != this->ownId && !(simMode && dynamic_cast<const essentials::BroadcastID*>(receiverId))) {
+        if (!simMode) {
+            return;
+        }
+    } else if (this->pmRegistry->getRobotId(pc->receiver_id.id) != this->ownId) {
         return;
     }
 
@@ -154,12 +151,38 @@ void ProcessManager::handleProcessCommand(process_manager::ProcessCommandPtr pc)
     }
 }
 
-void ProcessManager::changeLogPublishing(process_manager::ProcessCommandPtr pc, bool shouldPublish)
+/**
+ * @return The robot IDs of the given command, which are decoded from robot_ids_packed, if it is set.
+ */
+std::vector<essentials::AgentID> ProcessManager::getRobotIDs(process_manager::ProcessCommandPtr pc)
 {
+    std::vector<essentials::AgentID> robotIDs;
+    if (!pc->robot_ids_packed.empty()) {
+        try {
+            essentials::AgentIDCodec::decode(pc->robot_ids_packed, robotIDs);
+        } catch (const std::exception& e) {
+            cerr << "PM: Received malformed process command! " << e.what() << endl;
+            robotIDs.clear();
+        }
+        return robotIDs;
+    }
+    robotIDs.reserve(pc->robot_ids.size());
     for (const auto& agentIDros : pc->robot_ids) {
+        if (agentIDros.id.size() > essentials::AgentID::MAX_SIZE) {
+            cerr << "PM: Received malformed process command! Ignoring a robot ID of " << agentIDros.id.size() << " bytes." << endl;
+            continue;
+        }
+        robotIDs.emplace_back(agentIDros.id.data(), agentIDros.id.size(), agentIDros.type);
+    }
+    return robotIDs;
+}
+
+void ProcessManager::changeLogPublishing(process_manager::ProcessCommandPtr pc, bool shouldPublish)
+{
+    for (const essentials::AgentID& robotID : getRobotIDs(pc)) {
         // Check whether the robot with the given id is known
         std::string robotName;
-        if (const essentials::AgentID* agentID = this->pmRegistry->getRobotId(agentIDros.id, robotName)) {
+        if (const essentials::AgentID* agentID = this->pmRegistry->getRobotId(robotID.getRaw(), robotID.getSize(), robotName)) {
             // Find the ManagedRobot object
             auto mapIter = this->robotMap.find(agentID);
             ManagedRobot* mngdRobot;
@@ -192,10 +215,10 @@ void ProcessManager::changeDesiredProcessStates(process_manager::ProcessCommandP
         return;
     }
 
-    for (const auto& agentIDros : pc->robot_ids) {
+    for (const essentials::AgentID& robotID : getRobotIDs(pc)) {
         // Check whether the robot with the given id is known
         std::string robotName;
-        if (const essentials::AgentID* agentID = this->pmRegistry->getRobotId(agentIDros.id, robotName)) {
+        if (const essentials::AgentID* agentID = this->pmRegistry->getRobotId(robotID.getRaw(), robotID.getSize(), robotName)) {
             // Find the ManagedRobot object
             auto mapIter = this->robotMap.find(agentID);
             ManagedRobot* mngdRobot;
@@ -313,10 +336,14 @@ void ProcessManager::report()
 {
     process_manager::ProcessStats psts;
     psts.sender_id.id = this->ownId->toByteVector();
+    std::vector<const essentials::AgentID*> robotIDs;
     for (auto const& mngdRobot : this->robotMap) {
         // cout << "PM: report() We try to add another ProcessStat from " << mngdRobot.second->name << "!" << endl;
         mngdRobot.second->report(psts);
+        robotIDs.resize(psts.process_stats.size(), mngdRobot.first);
     }
+    // each robot is sent once, however many of its processes are reported
+    essentials::AgentIDCodec::encode(robotIDs, psts.robot_ids_packed);
     // cout << "PM: report() We have " << psts.processStats.size() << " ProcessStats!" << endl;
     this->processStatePub.publish(psts);
 }
@@ -7,6 +7,7 @@
 
 #include <essentials/AgentIDFactory.h>
 #include <essentials/AgentIDManager.h>
+#include <essentials/SharedAgentIDRegistry.h>
 
 #include <iostream>
 #include <string.h>
@@ -33,10 +34,29 @@ RobotExecutableRegistry* RobotExecutableRegistry::get()
 
 RobotExecutableRegistry::RobotExecutableRegistry()
         : sc(essentials::SystemConfig::getInstance())
-        , agentIDManager(new essentials::AgentIDManager(new essentials::AgentIDFactory()))
+        , agentIDManager(createAgentIDManager(this->sc))
 {
 }
 
+/**
+ * Interns the IDs in the host-wide shared memory segment named by Globals.SharedIDRegistry in the
+ * Globals.conf, so all processes of the host agree on them and their handles. Without that entry,
+ * or if the segment cannot be opened, the IDs are interned by this process only.
+ */
+essentials::AgentIDManager* RobotExecutableRegistry::createAgentIDManager(essentials::SystemConfig* sc)
+{
+    std::string registryName;
+    try {
+        registryName = (*sc)["Globals"]->tryGet<string>("", "Globals", "SharedIDRegistry", NULL);
+        if (!registryName.empty()) {
+            return new essentials::AgentIDManager(new essentials::AgentIDFactory(), new essentials::SharedAgentIDRegistry(registryName));
+        }
+    } catch (const std::exception& e) {
+        cerr << "RobotExecutableReg: Cannot use the shared ID registry '" << registryName << "': " << e.what() << endl;
+    }
+    return new essentials::AgentIDManager(new essentials::AgentIDFactory());
+}
+
 RobotExecutableRegistry::~RobotExecutableRegistry()
 {
     for (auto metaData : this->executableList) {
@@ -75,13 +95,57 @@ const map<string, vector<pair<int, int>>>* const RobotExecutableRegistry::getBun
     return &bundlesMap;
 }
 
+/**
+ * @return The ID interned by this registry, which is equal to the given one, or nullptr for empty and broadcast IDs.
+ */
+const essentials::AgentID* RobotExecutableRegistry::intern(const essentials::AgentID* agentID)
+{
+    if (agentID == nullptr) {
+        return nullptr;
+    }
+    // IDs of known robots are usually the interned ones already
+    if (this->findRobot(agentID) != nullptr) {
+        return agentID;
+    }
+    return this->agentIDManager->getIDFromBytes(agentID->getRaw(), agentID->getSize());
+}
+
+/**
+ * @return The ID interned by this registry, which is equal to the given one, or nullptr, if there is none.
+ * Unlike intern(), it never interns, so queries about unknown IDs leave no trace in the AgentIDManager.
+ */
+const essentials::AgentID* RobotExecutableRegistry::lookup(const essentials::AgentID* agentID)
+{
+    if (agentID == nullptr) {
+        return nullptr;
+    }
+    if (this->findRobot(agentID) != nullptr) {
+        return agentID;
+    }
+    return this->agentIDManager->findIDFromBytes(agentID->getRaw(), agentID->getSize());
+}
+
+/**
+ * Looks the robot up by the handle of its interned ID.
+ */
+RobotMetaData* RobotExecutableRegistry::findRobot(const essentials::AgentID* agentID) const
+{
+    if (agentID == nullptr || agentID->getHandle() >= this->robotsByHandle.size()) {
+        return nullptr;
+    }
+    RobotMetaData* robot = this->robotsByHandle[agentID->getHandle()];
+    // IDs of other managers may carry the same handle
+    if (robot == nullptr || robot->agentID != agentID) {
+        return nullptr;
+    }
+    return robot;
+}
+
 bool RobotExecutableRegistry::getRobotName(const essentials::AgentID* agentID, string& robotName)
 {
-    for (auto& agentEntry : this->robotMap) {
-        if (*(agentEntry.second->agentID) == *agentID) {
-            robotName = agentEntry.second->name;
-            return true;
-        }
+    if (RobotMetaData* robot = this->findRobot(this->lookup(agentID))) {
+        robotName = robot->name;
+        return true;
     }
     robotName = "";
     return false;
@@ -89,36 +153,54 @@ bool RobotExecutableRegistry::getRobotName(const essentials::AgentID* agentID, s
 
 bool RobotExecutableRegistry::robotExists(const essentials::AgentID* agentID)
 {
-    return this->robotMap.find(agentID) != this->robotMap.end();
+    return this->findRobot(this->lookup(agentID)) != nullptr;
 }
 
 bool RobotExecutableRegistry::robotExists(string robotName)
 {
-    for (auto& agentEntry : this->robotMap) {
-        if (agentEntry.second->name == robotName) {
-            return true;
-        }
-    }
-    return false;
+    return this->robotsByName.find(robotName) != this->robotsByName.end();
 }
 
 const essentials::AgentID* RobotExecutableRegistry::getRobotId(const std::string& robotName) const
 {
-    for (auto& agentEntry : this->robotMap) {
-        if (agentEntry.second->name == robotName) {
-            return agentEntry.second->agentID;
-        }
+    auto robotEntry = this->robotsByName.find(robotName);
+    if (robotEntry == this->robotsByName.end()) {
+        return nullptr;
     }
-    return nullptr;
+    return robotEntry->second->agentID;
 }
 
 const essentials::AgentID* RobotExecutableRegistry::getRobotId(const std::vector<uint8_t>& idVector, std::string& robotName)
 {
-    auto agentID = this->agentIDManager->getIDFromBytes(idVector);
-    auto agentEntry = this->robotMap.find(agentID);
-    if (agentEntry != this->robotMap.end()) { // entry already exists -> delete created id and return existing data
-        robotName = agentEntry->second->name;
-        return agentEntry->first;
+    return this->getRobotId(idVector.data(), idVector.size(), robotName);
+}
+
+/**
+ * IDs arrive from the network, so malformed ones are dropped here instead of throwing inside a callback.
+ */
+const essentials::AgentID* RobotExecutableRegistry::getValidID(const uint8_t* idBytes, size_t idSize)
+{
+    if (idSize > essentials::AgentID::MAX_SIZE) {
+        std::cerr << "RobotExecutableReg: Ignoring an ID of " << idSize << " bytes, which exceeds the maximum of " << essentials::AgentID::MAX_SIZE
+                  << " bytes!" << std::endl;
+        return nullptr;
+    }
+    return this->agentIDManager->getIDFromBytes(idBytes, idSize);
+}
+
+/**
+ * @return The ID of the given bytes or nullptr, if the bytes are empty or longer than an AgentID can be.
+ * Unknown robots are added to the registry.
+ */
+const essentials::AgentID* RobotExecutableRegistry::getRobotId(const uint8_t* idBytes, size_t idSize, std::string& robotName)
+{
+    auto agentID = this->getValidID(idBytes, idSize);
+    if (agentID == nullptr) {
+        return nullptr;
+    }
+    if (RobotMetaData* robot = this->findRobot(agentID)) { // entry already exists -> return existing data
+        robotName = robot->name;
+        return agentID;
     } else { // add unknown agent to map and return created id;
         this->addRobot(agentID);
         return agentID;
@@ -127,11 +209,17 @@ const essentials::AgentID* RobotExecutableRegistry::getRobotId(const std::vector
 
 const essentials::AgentID* RobotExecutableRegistry::getRobotId(const vector<uint8_t>& idVector)
 {
-    auto agentID = this->agentIDManager->getIDFromBytes(idVector);
-    auto agentEntry = this->robotMap.find(agentID);
+    return this->getRobotId(idVector.data(), idVector.size());
+}
 
-    if (agentEntry != this->robotMap.end()) {
-        return agentEntry->first;
+const essentials::AgentID* RobotExecutableRegistry::getRobotId(const uint8_t* idBytes, size_t idSize)
+{
+    auto agentID = this->getValidID(idBytes, idSize);
+    if (agentID == nullptr) {
+        return nullptr;
+    }
+    if (this->findRobot(agentID) != nullptr) {
+        return agentID;
     } else {
         this->addRobot(agentID);
         return agentID;
@@ -140,10 +228,18 @@ const essentials::AgentID* RobotExecutableRegistry::getRobotId(const vector<uint
 
 void RobotExecutableRegistry::addRobot(string robotName, const essentials::AgentID* agentID)
 {
-    auto robotEntry = this->robotMap.find(agentID);
-    if (robotEntry == this->robotMap.end()) {
-        this->robotMap.emplace(agentID, new RobotMetaData(robotName, agentID));
+    agentID = this->intern(agentID);
+    if (agentID == nullptr || this->findRobot(agentID) != nullptr) {
+        return;
+    }
+    RobotMetaData* robot = new RobotMetaData(robotName, agentID);
+    this->robotMap.emplace(agentID, robot);
+    if (agentID->getHandle() >= this->robotsByHandle.size()) {
+        this->robotsByHandle.resize(this->agentIDManager->getIDCount(), nullptr);
     }
+    this->robotsByHandle[agentID->getHandle()] = robot;
+    // robots added later under a taken name are only found by their IDs
+    this->robotsByName.emplace(robotName, robot);
 }
 
 /**
@@ -182,7 +278,7 @@ const essentials::AgentID* RobotExecutableRegistry::addRobot(string agentName)
         do {
             // generates random ID
             agentID = this->agentIDManager->generateID();
-        } while (this->robotMap.find(agentID) != this->robotMap.end());
+        } while (this->findRobot(agentID) != nullptr);
         std::cout << "PM Registry: Warning! Adding unknown agent " << agentName << " with ID " << *agentID << "!" << std::endl;
     }
 
@@ -190,7 +286,7 @@ const essentials::AgentID* RobotExecutableRegistry::addRobot(string agentName)
     return agentID;
 }
 
-const std::map<const essentials::AgentID*, RobotMetaData*, essentials::AgentIDComparator>& RobotExecutableRegistry::getRobots() const
+const std::map<const essentials::AgentID*, RobotMetaData*, essentials::AgentIDHandleComparator>& RobotExecutableRegistry::getRobots() const
 {
     return this->robotMap;
 }
@@ -0,0 +1,34 @@
+## Generates a header with a struct and a one-pass loader from a configuration schema
+## (see src/ConfigSchemaGenerator.cpp). The header is written to
+## ${CMAKE_CURRENT_BINARY_DIR}/config_schema/<struct_name>.h, which is added to the include
+## directories. The generator keeps the timestamp of an unchanged header, so the command depends
+## on a stamp file instead. The paths of the header and the stamp are stored in output_var, which
+## is added to the sources of the target, e.g.
+##
+##   config_schema_generate(${CMAKE_CURRENT_SOURCE_DIR}/etc/Motion.schema MotionConfig my_ns MOTION_CONFIG_HEADER)
+##   add_executable(my_node src/main.cpp ${MOTION_CONFIG_HEADER})
+function(config_schema_generate schema struct_name namespace output_var)
+  if (TARGET config_schema_generator)
+    set(generator $<TARGET_FILE:config_schema_generator>)
+    set(generator_target config_schema_generator)
+  else()
+    find_program(CONFIG_SCHEMA_GENERATOR config_schema_generator
+      PATHS "${system_config_DIR}/../../../lib/system_config" "${CATKIN_DEVEL_PREFIX}/lib/system_config")
+    set(generator ${CONFIG_SCHEMA_GENERATOR})
+  endif()
+
+  set(output_dir "${CMAKE_CURRENT_BINARY_DIR}/config_schema")
+  set(header "${output_dir}/${struct_name}.h")
+  set(stamp "${output_dir}/${struct_name}.stamp")
+  add_custom_command(
+    OUTPUT ${stamp}
+    BYPRODUCTS ${header}
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${output_dir}
+    COMMAND ${generator} ${schema} ${header} ${struct_name} ${namespace}
+    COMMAND ${CMAKE_COMMAND} -E touch ${stamp}
+    DEPENDS ${schema} ${generator_target}
+    COMMENT "Generating ${struct_name} from ${schema}"
+  )
+  include_directories(${output_dir})
+  set(${output_var} ${header} ${stamp} PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SC_HAVE_TSC 1
+#endif
+
+namespace essentials
+{
+
+/**
+ * Cheap timestamps for logging and tracing. All clocks are read without a system call
+ * (clock_gettime is served by the vDSO) and are returned in nanoseconds or in DateTime ticks
+ * (100 ns since 0001-01-01).
+ *
+ * REALTIME follows the wall clock, including its jumps. MONOTONIC never jumps and is converted to
+ * wall clock time with the offset measured on first use. The COARSE variants only advance once per
+ * kernel tick (usually 1-4 ms), but cost a fraction of a fine-grained read. TSC reads the time
+ * stamp counter, calibrated against MONOTONIC within 20 ms on its first use, and falls back to MONOTONIC
+ * on CPUs without an invariant TSC. As the calibration is not refined later, TSC timestamps drift
+ * away from MONOTONIC by a few microseconds per second, so they suit tracing, not wall clock time.
+ */
+class ClockSource
+{
+public:
+    enum Clock
+    {
+        REALTIME,
+        REALTIME_COARSE,
+        MONOTONIC,
+        MONOTONIC_COARSE,
+        TSC
+    };
+
+    /**
+     * @return The nanoseconds of the given clock. Only REALTIME and REALTIME_COARSE count since the Unix epoch.
+     */
+    static inline int64_t getNanos(Clock clock)
+    {
+        switch (clock) {
+        case REALTIME:
+            return readClock(CLOCK_REALTIME);
+        case REALTIME_COARSE:
+            return readClock(CLOCK_REALTIME_COARSE);
+        case MONOTONIC:
+            return readClock(CLOCK_MONOTONIC);
+        case MONOTONIC_COARSE:
+            return readClock(CLOCK_MONOTONIC_COARSE);
+        case TSC:
+        default:
+            return readTsc();
+        }
+    }
+
+    /**
+     * @return The current time of the given clock as DateTime ticks.
+     */
+    static inline long long getTicks(Clock clock)
+    {
+        return (getNanos(clock) + getEpochOffsets().offsets[clock]) / 100 + EPOCH_TICKS;
+    }
+
+    static bool hasInvariantTsc();
+    static double getTscFrequency();
+
+private:
+    static const long long EPOCH_TICKS = 621355968000000000LL; /**< 0001-01-01 to 1970-01-01 in DateTime ticks */
+
+    struct EpochOffsets
+    {
+        int64_t offsets[TSC + 1]; /**< Added to the nanoseconds of each clock to get nanoseconds since the Unix epoch */
+    };
+
+    struct TscCalibration
+    {
+        bool tsc; /**< The TSC is invariant and calibrated */
+        uint64_t tscStart;
+        int64_t tscStartNanos; /**< CLOCK_MONOTONIC at tscStart */
+        double nanosPerTscTick;
+    };
+
+    static EpochOffsets measureEpochOffsets();
+    static TscCalibration calibrateTsc();
+
+    static inline const EpochOffsets& getEpochOffsets()
+    {
+        static const EpochOffsets epochOffsets = measureEpochOffsets();
+        return epochOffsets;
+    }
+
+    /**
+     * Only the first read of the TSC clock waits for the calibration, the other clocks never do.
+     */
+    static inline const TscCalibration& getTscCalibration()
+    {
+        static const TscCalibration calibration = calibrateTsc();
+        return calibration;
+    }
+
+    static inline int64_t readClock(clockid_t id)
+    {
+        struct timespec ts;
+        clock_gettime(id, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    static inline int64_t readTsc()
+    {
+        const TscCalibration& calibration = getTscCalibration();
+#ifdef SC_HAVE_TSC
+        if (calibration.tsc) {
+            return calibration.tscStartNanos + static_cast<int64_t>(static_cast<int64_t>(__rdtsc() - calibration.tscStart) * calibration.nanosPerTscTick);
+        }
+#endif
+        (void) calibration;
+        return readClock(CLOCK_MONOTONIC);
+    }
+};
+} // namespace essentials
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Configuration.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace essentials
+{
+
+/**
+ * The configurations as seen by a single agent: the files of the config folder, overlaid by the
+ * ones of the agent's host-specific subfolder. Several contexts can be used in one process, e.g.
+ * for simulating many robots. Global files, which are not overlaid, are parsed once and shared by
+ * all contexts, until one of them changes its copy with set().
+ *
+ * SystemConfig forwards to a default context for the own robot.
+ */
+class ConfigContext
+{
+public:
+    ConfigContext(const std::string& configPath, const std::string& hostname);
+    ~ConfigContext();
+
+    Configuration* operator[](const std::string& configName);
+
+    std::string getConfigPath() const;
+    void setConfigPath(const std::string& configPath);
+    std::string getHostname() const;
+    void setHostname(const std::string& hostname);
+    void setLazyLoading(bool lazy);
+
+    size_t preload(unsigned int threads = 0);
+    std::vector<std::string> getFolders() const;
+    Configuration* reloadFile(const std::string& folder, const std::string& file);
+
+private:
+    /**
+     * Cache entry of a single configuration file. Each entry is loaded exactly once, so
+     * concurrent first accesses of different files do not wait for each other.
+     */
+    struct ConfigEntry
+    {
+        ConfigEntry()
+                : loaded(false)
+        {
+        }
+        std::once_flag loadOnce;
+        std::atomic<bool> loaded;
+        std::shared_ptr<Configuration> config; /**< nullptr, if the file was not found */
+    };
+    /**
+     * Stable slot of a configuration name. Slots are only prepended to their bucket and never
+     * removed, so readers walk the chains without locking. The entry is replaced on reloads and
+     * is nullptr, until the configuration is accessed again.
+     */
+    struct ConfigSlot
+    {
+        ConfigSlot(const std::string& name, ConfigSlot* next)
+                : name(name)
+                , entry(nullptr)
+                , next(next)
+        {
+        }
+        const std::string name;
+        std::atomic<ConfigEntry*> entry;
+        ConfigSlot* const next;
+    };
+    static const size_t CONFIG_BUCKETS = 64;
+
+    mutable std::mutex pathsMutex; /**< Protects configPath and hostname */
+    std::string configPath;
+    std::string hostname;
+    std::atomic<bool> lazyLoading;
+
+    std::mutex configsMutex; /**< Serialises writers of the buckets */
+    std::atomic<ConfigSlot*> buckets[CONFIG_BUCKETS];
+    std::vector<std::unique_ptr<ConfigSlot>> slots;    /**< One per configuration name ever accessed */
+    std::vector<std::unique_ptr<ConfigEntry>> entries; /**< Includes replaced entries, as their configurations may still be in use */
+
+    ConfigSlot* findSlot(const std::string& configName) const;
+    ConfigEntry* findEntry(const std::string& configName);
+    ConfigEntry* getOrCreateEntry(const std::string& configName);
+    void loadEntry(const std::string& configName, ConfigEntry* entry);
+    bool loadConfigFiles(Configuration* config, const std::string& configName);
+    void clearConfigs();
+    void forgetMissingConfigs();
+};
+} // namespace essentials
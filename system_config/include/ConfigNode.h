@@ -7,8 +7,16 @@
 
 #pragma once
 
+#include "ConfigPath.h"
+
+#include <atomic>
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
 
 namespace essentials
 {
@@ -25,17 +33,65 @@ public:
         Comment = 2,
     } Type;
 
+    /**
+     * Creates the children of a lazily loaded section from its content, when they are accessed for the first time.
+     */
+    typedef std::function<void(ConfigNode*, const std::string&)> Materializer;
+
 protected:
+    struct LazyChildren
+    {
+        LazyChildren(Materializer materialize, std::shared_ptr<const std::string> text, size_t begin, size_t end)
+                : materialize(materialize)
+                , text(text)
+                , begin(begin)
+                , end(end)
+                , done(false)
+        {
+        }
+        std::once_flag once;
+        Materializer materialize;
+        std::shared_ptr<const std::string> text; /**< Content of the whole file, the section is [begin, end) */
+        size_t begin;
+        size_t end;
+        std::atomic<bool> done;
+    };
+
     std::string name;
+    uint64_t nameHash;
     std::string value;
     ConfigNode* parent;
     std::vector<ConfigNodePtr> children;
     int depth;
     Type type;
+    std::shared_ptr<LazyChildren> lazy; /**< Set for sections, whose children are not parsed yet */
+
+    void materialize() const
+    {
+        if (this->lazy) {
+            ConfigNode* self = const_cast<ConfigNode*>(this);
+            std::call_once(this->lazy->once, [self]() {
+                LazyChildren* lazy = self->lazy.get();
+                std::shared_ptr<const std::string> text = std::atomic_load(&lazy->text);
+                try {
+                    lazy->materialize(self, text->substr(lazy->begin, lazy->end - lazy->begin));
+                } catch (...) {
+                    // start over on the next access
+                    self->children.clear();
+                    throw;
+                }
+                // releases the content of the file, once all sections are parsed
+                lazy->materialize = nullptr;
+                std::atomic_store(&lazy->text, std::shared_ptr<const std::string>());
+                self->lazy->done.store(true, std::memory_order_release);
+            });
+        }
+    }
 
 public:
     ConfigNode(const std::string& name)
             : name(name)
+            , nameHash(ConfigPathSegment::hashRuntime(name.c_str(), name.size()))
             , value()
             , parent(nullptr)
             , children()
@@ -46,6 +102,7 @@ public:
 
     ConfigNode(Type type, const std::string& name)
             : name(name)
+            , nameHash(ConfigPathSegment::hashRuntime(name.c_str(), name.size()))
             , value()
             , parent(nullptr)
             , children()
@@ -56,6 +113,7 @@ public:
 
     ConfigNode(const std::string& name, const std::string& value)
             : name(name)
+            , nameHash(ConfigPathSegment::hashRuntime(name.c_str(), name.size()))
             , value(value)
             , parent(nullptr)
             , children()
@@ -66,9 +124,10 @@ public:
 
     ConfigNode(const ConfigNode& other)
             : name(other.name)
+            , nameHash(other.nameHash)
             , value(other.value)
             , parent(other.parent)
-            , children(other.children)
+            , children((other.materialize(), other.children))
             , depth(other.depth)
             , type(other.type)
     {
@@ -97,7 +156,58 @@ public:
         return this->children.back().get();
     }
 
-    std::vector<ConfigNodePtr>* getChildren() { return &this->children; }
+    /**
+     * Creates a section, whose children are created from the range [begin, end) of text on first access.
+     */
+    ConfigNode* createLazy(const std::string& name, Materializer materialize, std::shared_ptr<const std::string> text, size_t begin, size_t end)
+    {
+        ConfigNode* node = this->create(name);
+        node->lazy = std::make_shared<LazyChildren>(materialize, text, begin, end);
+        return node;
+    }
+
+    std::vector<ConfigNodePtr>* getChildren()
+    {
+        this->materialize();
+        return &this->children;
+    }
+
+    bool isMaterialized() const { return !this->lazy || this->lazy->done.load(std::memory_order_acquire); }
+
+    /**
+     * Writes the content of a lazily loaded section as it was read from the file.
+     * @return false, if the section has been parsed already.
+     */
+    bool writeRawContent(std::ostream* os) const
+    {
+        if (!this->lazy) {
+            return false;
+        }
+        std::shared_ptr<const std::string> text = std::atomic_load(&this->lazy->text);
+        if (!text || this->isMaterialized()) {
+            return false;
+        }
+        os->write(text->data() + this->lazy->begin, this->lazy->end - this->lazy->begin);
+        return true;
+    }
+
+    /**
+     * Copies this node and all of its children, e.g. before changing a tree shared by several configurations.
+     * @param parent The parent of the copy or nullptr for a root.
+     */
+    ConfigNodePtr clone(ConfigNode* parent = nullptr) const
+    {
+        this->materialize();
+        ConfigNodePtr copy = std::make_shared<ConfigNode>(this->type, this->name);
+        copy->value = this->value;
+        if (parent != nullptr) {
+            copy->setParent(parent);
+        }
+        for (const ConfigNodePtr& child : this->children) {
+            copy->children.push_back(child->clone(copy.get()));
+        }
+        return copy;
+    }
 
     ConfigNode* getParent() const { return this->parent; }
 
@@ -113,6 +223,13 @@ public:
 
     const std::string& getName() const { return this->name; }
 
+    uint64_t getNameHash() const { return this->nameHash; }
+
+    /**
+     * Compares the hashes first, so mismatching names are mostly rejected without a string compare.
+     */
+    bool matches(const ConfigPathSegment& segment) const { return this->nameHash == segment.hash && segment.equals(this->name); }
+
     int getDepth() const { return this->depth; }
 
     Type getType() const { return this->type; }
@@ -120,8 +237,10 @@ public:
     ConfigNode& operator=(const ConfigNode& other)
     {
         this->name = other.name;
+        this->nameHash = other.nameHash;
         this->value = other.value;
         this->parent = other.parent;
+        other.materialize();
         this->children = other.children;
         this->depth = other.depth;
         this->type = other.type;
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "Configuration.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace essentials
+{
+
+/**
+ * Holds the current value of a bound parameter. Arithmetic values live in a std::atomic,
+ * everything else is published as an immutable copy.
+ */
+template <typename T, bool Atomic = std::is_arithmetic<T>::value>
+class ConfigValue
+{
+public:
+    ConfigValue()
+            : value(T())
+    {
+    }
+    T load() const { return this->value.load(std::memory_order_acquire); }
+    void store(const T& newValue) { this->value.store(newValue, std::memory_order_release); }
+
+private:
+    std::atomic<T> value;
+};
+
+template <typename T>
+class ConfigValue<T, false>
+{
+public:
+    ConfigValue()
+            : value(std::make_shared<const T>())
+    {
+    }
+    T load() const { return *std::atomic_load(&this->value); }
+    void store(const T& newValue) { std::atomic_store(&this->value, std::shared_ptr<const T>(std::make_shared<const T>(newValue))); }
+
+private:
+    std::shared_ptr<const T> value;
+};
+
+/**
+ * Base of everything that is bound to a path of a Configuration and refreshed
+ * whenever the Configuration is reloaded or changed via set().
+ */
+class ConfigBinding
+{
+public:
+    ConfigBinding(const ConfigPath& path)
+            : path(path.toVector())
+    {
+    }
+    virtual ~ConfigBinding() {}
+
+    /**
+     * Re-resolves the path in the given tree and publishes the new value.
+     * @return false, if the path does not exist in the tree.
+     */
+    virtual bool refresh(Configuration* config, ConfigNode* root) = 0;
+
+    const std::vector<std::string>& getPath() const { return this->path; }
+
+protected:
+    std::vector<std::string> path; /**< Owned copy of the path, as ConfigPaths do not own their segments */
+};
+
+template <typename T>
+class ConfigParamBinding : public ConfigBinding
+{
+public:
+    ConfigParamBinding(const ConfigPath& path)
+            : ConfigBinding(path)
+    {
+    }
+
+    bool refresh(Configuration* config, ConfigNode* root)
+    {
+        ConfigNode* node = config->findFirst(root, ConfigPath(this->path), 0);
+        if (node == nullptr) {
+            return false;
+        }
+        this->value.store(config->convert<T>(node->getValue()));
+        return true;
+    }
+
+    T get() const { return this->value.load(); }
+
+private:
+    ConfigValue<T> value;
+};
+
+/**
+ * A parameter that is resolved once and afterwards read with a single atomic load.
+ * The value follows reloads of its Configuration and calls of set(), e.g.:
+ *
+ * ConfigParam<double> maxSpeed = (*sc)["Drive"]->bind<double>("Drive", "MaxSpeed");
+ * while (running) { drive(maxSpeed.get()); }
+ */
+template <typename T>
+class ConfigParam
+{
+public:
+    ConfigParam() {}
+    ConfigParam(std::shared_ptr<ConfigParamBinding<T>> binding)
+            : binding(binding)
+    {
+    }
+
+    T get() const { return this->binding->get(); }
+    operator T() const { return this->binding->get(); }
+
+private:
+    std::shared_ptr<ConfigParamBinding<T>> binding;
+};
+
+/**
+ * Maps a key of a section to a member of the struct S, e.g. ConfigField<Gains>("kp", &Gains::kp).
+ */
+template <typename S>
+class ConfigField
+{
+public:
+    template <typename M>
+    ConfigField(const std::string& name, M S::*member)
+            : name(name)
+            , assign([member](Configuration* config, const std::string& value, S& target) { target.*member = config->convert<M>(value); })
+    {
+    }
+
+    std::string name;
+    std::function<void(Configuration*, const std::string&, S&)> assign;
+};
+
+template <typename S>
+class ConfigStructBinding : public ConfigBinding
+{
+public:
+    ConfigStructBinding(const ConfigPath& section, const std::vector<ConfigField<S>>& fields)
+            : ConfigBinding(section)
+            , fields(fields)
+    {
+    }
+
+    /**
+     * Fills all fields from the given tree and publishes them at once, so readers
+     * never see a mix of old and new fields.
+     */
+    bool refresh(Configuration* config, ConfigNode* root)
+    {
+        S newValue = this->value.load();
+        for (const ConfigField<S>& field : this->fields) {
+            std::vector<std::string> fieldPath = this->path;
+            fieldPath.push_back(field.name);
+            ConfigNode* node = config->findFirst(root, ConfigPath(fieldPath), 0);
+            if (node == nullptr) {
+                return false;
+            }
+            field.assign(config, node->getValue(), newValue);
+        }
+        this->value.store(newValue);
+        return true;
+    }
+
+    S get() const { return this->value.load(); }
+
+private:
+    std::vector<ConfigField<S>> fields;
+    ConfigValue<S, false> value;
+};
+
+/**
+ * A whole struct bound to a section of a Configuration. get() returns a consistent copy.
+ */
+template <typename S>
+class ConfigStruct
+{
+public:
+    ConfigStruct() {}
+    ConfigStruct(std::shared_ptr<ConfigStructBinding<S>> binding)
+            : binding(binding)
+    {
+    }
+
+    S get() const { return this->binding->get(); }
+
+private:
+    std::shared_ptr<ConfigStructBinding<S>> binding;
+};
+
+template <typename T>
+ConfigParam<T> Configuration::bind(const ConfigPath& path)
+{
+    std::shared_ptr<ConfigParamBinding<T>> binding = std::make_shared<ConfigParamBinding<T>>(path);
+    this->addBinding(binding);
+    return ConfigParam<T>(binding);
+}
+
+template <typename S>
+ConfigStruct<S> Configuration::bindStruct(const std::vector<ConfigField<S>>& fields, const ConfigPath& section)
+{
+    std::shared_ptr<ConfigStructBinding<S>> binding = std::make_shared<ConfigStructBinding<S>>(section, fields);
+    this->addBinding(binding);
+    return ConfigStruct<S>(binding);
+}
+} // namespace essentials
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace essentials
+{
+
+/**
+ * A single, non-owning segment of a configuration path together with its FNV-1a hash.
+ * Segments created from string literals are hashed at compile time, e.g.
+ * static constexpr ConfigPathSegment TEAM("Team");
+ */
+struct ConfigPathSegment
+{
+    static constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325;
+    static constexpr uint64_t FNV_PRIME = 0x00000100000001b3;
+
+    const char* name;
+    size_t length;
+    uint64_t hash;
+    bool dotted; /**< true, if the segment still contains '.' separators and needs to be split */
+
+    constexpr ConfigPathSegment()
+            : name("")
+            , length(0)
+            , hash(FNV_OFFSET)
+            , dotted(false)
+    {
+    }
+
+    template <size_t N>
+    constexpr ConfigPathSegment(const char (&literal)[N])
+            : name(literal)
+            , length(N - 1)
+            , hash(hashConst(literal, N - 1, FNV_OFFSET))
+            , dotted(containsDot(literal, N - 1))
+    {
+    }
+
+    /**
+     * Buffers, which are not const, are no literals, so only their content up to the first null counts.
+     */
+    template <size_t N>
+    ConfigPathSegment(char (&buffer)[N])
+            : ConfigPathSegment(buffer, strnlen(buffer, N))
+    {
+    }
+
+    ConfigPathSegment(const char* name, size_t length)
+            : name(name)
+            , length(length)
+            , hash(hashRuntime(name, length))
+            , dotted(memchr(name, '.', length) != nullptr)
+    {
+    }
+
+    bool equals(const std::string& other) const { return other.size() == this->length && other.compare(0, this->length, this->name, this->length) == 0; }
+
+    static constexpr uint64_t hashConst(const char* str, size_t len, uint64_t hash)
+    {
+        return len == 0 ? hash : hashConst(str + 1, len - 1, (hash ^ static_cast<uint8_t>(*str)) * FNV_PRIME);
+    }
+
+    static inline uint64_t hashRuntime(const char* str, size_t len)
+    {
+        uint64_t hash = FNV_OFFSET;
+        for (size_t i = 0; i < len; i++) {
+            hash = (hash ^ static_cast<uint8_t>(str[i])) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    static constexpr bool containsDot(const char* str, size_t len) { return len != 0 && (*str == '.' || containsDot(str + 1, len - 1)); }
+};
+
+class ConfigPath;
+
+/**
+ * Second parameter of the NULL-terminated va_list API. It needs a user-defined conversion,
+ * so calls without a trailing NULL prefer the variadic templates.
+ */
+struct ConfigPathNext
+{
+    ConfigPathNext(const char* segment)
+            : segment(segment)
+    {
+    }
+    const char* segment;
+};
+
+/**
+ * Tells whether the given types can be passed as segments of a configuration path.
+ * NULL is not accepted, so NULL-terminated calls end up in the va_list API.
+ */
+template <typename... Args>
+struct isConfigPath;
+
+template <>
+struct isConfigPath<> : std::true_type
+{
+};
+
+template <typename Arg, typename... Args>
+struct isConfigPath<Arg, Args...>
+        : std::integral_constant<bool,
+                  (std::is_convertible<Arg, const char*>::value || std::is_convertible<Arg, std::string>::value ||
+                          std::is_convertible<Arg, ConfigPathSegment>::value) &&
+                          !std::is_integral<typename std::decay<Arg>::type>::value && !std::is_same<typename std::decay<Arg>::type, std::nullptr_t>::value &&
+                          !std::is_same<typename std::decay<Arg>::type, ConfigPath>::value && isConfigPath<Args...>::value>
+{
+};
+
+/**
+ * A configuration path, e.g. "Globals", "Team", name, "ID". Segments containing dots are
+ * split into several segments. The path does not copy any strings, so it must not outlive
+ * the arguments it was created from.
+ */
+class ConfigPath
+{
+public:
+    static const char SEPERATOR = '.';
+
+    template <typename... Segments, typename = typename std::enable_if<isConfigPath<Segments...>::value>::type>
+    explicit ConfigPath(Segments&&... segments)
+            : count(0)
+            , terminated(false)
+    {
+        this->append(std::forward<Segments>(segments)...);
+    }
+
+    ConfigPath(const std::vector<std::string>& segments);
+    ConfigPath(const char* path, ConfigPathNext next, va_list ap);
+
+    const ConfigPathSegment& operator[](size_t i) const { return i < INLINE_SEGMENTS ? this->inlineSegments[i] : this->moreSegments[i - INLINE_SEGMENTS]; }
+    size_t size() const { return this->count; }
+    std::vector<std::string> toVector() const;
+    std::string toString() const;
+
+private:
+    static const size_t INLINE_SEGMENTS = 8;
+
+    /**
+     * Wraps runtime strings, so that string literals prefer the compile-time overload.
+     */
+    struct RuntimeString
+    {
+        RuntimeString(const char* str)
+                : str(str)
+        {
+        }
+        const char* str;
+    };
+
+    void append() {}
+
+    template <typename Segment, typename... Segments>
+    void append(Segment&& segment, Segments&&... segments)
+    {
+        this->appendOne(std::forward<Segment>(segment));
+        this->append(std::forward<Segments>(segments)...);
+    }
+
+    template <size_t N>
+    void appendOne(const char (&literal)[N])
+    {
+        size_t length = strnlen(literal, N);
+        if (length == N - 1) {
+            this->add(ConfigPathSegment(literal));
+        } else {
+            // a const buffer, which is not filled up to its size
+            this->add(ConfigPathSegment(literal, length));
+        }
+    }
+
+    template <size_t N>
+    void appendOne(char (&buffer)[N])
+    {
+        this->add(ConfigPathSegment(buffer, strnlen(buffer, N)));
+    }
+
+    void appendOne(RuntimeString segment)
+    {
+        if (segment.str == nullptr) {
+            this->terminated = true;
+        } else {
+            this->add(ConfigPathSegment(segment.str, strlen(segment.str)));
+        }
+    }
+
+    template <typename String>
+    typename std::enable_if<std::is_same<typename std::decay<String>::type, std::string>::value>::type appendOne(const String& segment)
+    {
+        this->add(ConfigPathSegment(segment.c_str(), segment.size()));
+    }
+
+    void appendOne(const ConfigPathSegment& segment) { this->add(segment); }
+
+    void add(const ConfigPathSegment& segment);
+    void push(const ConfigPathSegment& segment);
+
+    size_t count;
+    bool terminated; /**< true, after a null pointer has been appended, which ends the path */
+    ConfigPathSegment inlineSegments[INLINE_SEGMENTS];
+    std::vector<ConfigPathSegment> moreSegments;
+};
+
+} // namespace essentials
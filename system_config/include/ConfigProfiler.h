@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ConfigPath.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace essentials
+{
+
+/**
+ * Counts configuration lookups and their cumulative time per file and path, in order to find
+ * hot lookups, which should be hoisted out of control loops. Disabled by default, in which case
+ * a lookup only costs a relaxed atomic load.
+ *
+ * Can be enabled via the environment variable CONFIG_PROFILE=<file>, which writes the report
+ * at shutdown and each time the process receives SIGUSR2. Reports to files ending in .json are
+ * written as JSON, everything else as a sorted text table.
+ */
+class ConfigProfiler
+{
+public:
+    struct Stats
+    {
+        Stats()
+                : count(0)
+                , misses(0)
+                , totalNanos(0)
+                , maxNanos(0)
+        {
+        }
+        uint64_t count;
+        uint64_t misses; /**< Lookups of paths, which did not exist, e.g. tryGet falling back to its default */
+        uint64_t totalNanos;
+        uint64_t maxNanos;
+    };
+
+    /**
+     * Measures a single lookup from construction to destruction.
+     */
+    class Scope
+    {
+    public:
+        Scope(const std::string& file, const ConfigPath& path)
+                : file(file)
+                , path(path)
+                , missed(false)
+                , active(ConfigProfiler::isEnabled())
+        {
+            if (this->active) {
+                this->start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Scope()
+        {
+            if (this->active) {
+                ConfigProfiler::record(this->file, this->path, this->missed, std::chrono::steady_clock::now() - this->start);
+            }
+        }
+
+        void miss() { this->missed = true; }
+
+    private:
+        const std::string& file;
+        const ConfigPath& path;
+        bool missed;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void enable();
+    static void disable();
+    static void reset();
+
+    static void record(const std::string& file, const ConfigPath& path, bool missed, std::chrono::steady_clock::duration duration);
+
+    static std::string report();
+    static std::string toJson();
+    static bool dump(const std::string& filename);
+
+    static void setDumpFile(const std::string& filename, int signal = 0);
+    static void shutdown();
+
+private:
+    typedef std::map<std::pair<std::string, std::string>, Stats> StatsMap;
+
+    static std::atomic<bool> enabled;
+    static std::mutex statsMutex;
+    static StatsMap stats;
+
+    static std::mutex dumpMutex;
+    static std::string dumpFile;
+    static int dumpSignal;
+    static int signalPipe[2];
+    static std::thread* signalThread;
+
+    static void onSignal(int signal);
+    static void runSignalThread();
+};
+} // namespace essentials
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Configuration.h"
+#include "NumberListParser.h"
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace essentials
+{
+
+/**
+ * Runtime support of the structs generated by config_schema_generator. A generated struct mirrors
+ * the sections and keys of a schema file and fills all of its fields in one pass over the tree of
+ * a Configuration, so type errors and missing keys show up at load time and hot code reads plain
+ * fields instead of resolving paths.
+ */
+class ConfigSchema
+{
+public:
+    /**
+     * @return The current tree of the given configuration, which stays alive while it is held.
+     */
+    static ConfigNodePtr getRoot(Configuration* config) { return config->getRoot(); }
+
+    /**
+     * Converts the value of the given key into the given field. Numbers must consist of a single number only.
+     * @throws std::runtime_error, if the node is a section or its value does not match the field's type.
+     */
+    template <typename T>
+    static void read(Configuration* config, ConfigNode* node, T* field)
+    {
+        if (node->getType() != ConfigNode::Leaf) {
+            throw std::runtime_error(error(config, node, "is a section, but a value is expected"));
+        }
+        try {
+            readValue(config, node->getValue(), field, std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>());
+        } catch (std::exception& e) {
+            throw std::runtime_error(error(config, node, "has a malformed value: " + node->getValue()));
+        }
+    }
+
+    template <typename T>
+    static void read(Configuration* config, ConfigNode* node, std::vector<T>* field)
+    {
+        if (node->getType() != ConfigNode::Leaf) {
+            throw std::runtime_error(error(config, node, "is a section, but a list is expected"));
+        }
+        try {
+            *field = config->convertList<T>(node->getValue());
+        } catch (std::exception& e) {
+            throw std::runtime_error(error(config, node, "has a malformed list: " + node->getValue()));
+        }
+    }
+
+    /**
+     * @throws std::runtime_error, if the given node is not a section.
+     */
+    static void checkSection(Configuration* config, ConfigNode* node)
+    {
+        if (node->getType() != ConfigNode::Node) {
+            throw std::runtime_error(error(config, node, "is a value, but a section is expected"));
+        }
+    }
+
+    /**
+     * @throws std::runtime_error naming the first entry of the schema, which was not found in the given section.
+     */
+    static void checkFound(Configuration* config, ConfigNode* section, const char* const* names, const bool* found, size_t count)
+    {
+        for (size_t i = 0; i < count; i++) {
+            if (!found[i]) {
+                std::string path = getPath(section);
+                throw std::runtime_error("SC-Schema: " + config->getFilename() + ": " + (path.empty() ? "" : path + ".") + names[i] + " is missing");
+            }
+        }
+    }
+
+private:
+    template <typename T>
+    static void readValue(Configuration* /*config*/, const std::string& value, T* field, std::true_type /*numeric*/)
+    {
+        if (NumberListParser::parse(value, field, 1) != 1) {
+            throw std::runtime_error("SC-Schema: Empty value");
+        }
+    }
+
+    template <typename T>
+    static void readValue(Configuration* config, const std::string& value, T* field, std::false_type /*numeric*/)
+    {
+        *field = config->convert<T>(value);
+    }
+
+    static std::string getPath(ConfigNode* node)
+    {
+        std::string path;
+        for (; node != nullptr && node->getParent() != nullptr; node = node->getParent()) {
+            path = path.empty() ? node->getName() : node->getName() + "." + path;
+        }
+        return path;
+    }
+
+    static std::string error(Configuration* config, ConfigNode* node, const std::string& message)
+    {
+        return "SC-Schema: " + config->getFilename() + ": " + getPath(node) + " " + message;
+    }
+};
+} // namespace essentials
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace essentials
+{
+/**
+ * Watches a set of configuration folders via inotify and reports every *.conf file,
+ * which has been written or moved into one of them. The handler is called from the
+ * watcher's own thread, so it may take its time for re-parsing.
+ */
+class ConfigWatcher
+{
+public:
+    typedef std::function<void(const std::string& folder, const std::string& file)> ChangeHandler;
+
+    ConfigWatcher(ChangeHandler handler);
+    ~ConfigWatcher();
+
+    void setFolders(const std::vector<std::string>& folders);
+
+private:
+    void run();
+    void updateWatches();
+
+    ChangeHandler handler;
+    int inotifyFd;
+    int wakeupFd;
+    std::atomic<bool> running;
+    std::thread* runThread;
+
+    std::mutex watchesMutex;
+    std::vector<std::string> folders; /**< The folders, which should be watched, even if they do not exist, yet. */
+    std::map<int, std::string> watches; /**< Maps inotify watch descriptors to the watched folders. */
+};
+} // namespace essentials
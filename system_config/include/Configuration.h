@@ -1,34 +1,90 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cstdarg>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string>
+#include <type_traits>
 #include <vector>
 //#include "boost/lexical_cast.hpp"
 
 #include "ConfigNode.h"
+#include "ConfigPath.h"
+#include "ConfigProfiler.h"
+#include "NumberListParser.h"
 
 namespace essentials
 {
+class ConfigBinding;
+template <typename T>
+class ConfigParam;
+template <typename T>
+class ConfigParamBinding;
+template <typename S>
+class ConfigStruct;
+template <typename S>
+class ConfigStructBinding;
+template <typename S>
+class ConfigField;
+class ConfigSchema;
+
 class Configuration
 {
+    template <typename T>
+    friend class ConfigParamBinding;
+    template <typename S>
+    friend class ConfigStructBinding;
+    template <typename S>
+    friend class ConfigField;
+    friend class ConfigSchema;
+
 protected:
     static const char LIST_ELEMENT_SEPERATOR = ',';
-    std::string filename;
-    void collect(ConfigNode* node, std::vector<std::string>* params, size_t offset, std::vector<ConfigNode*>* result);
-    void collectSections(ConfigNode* node, std::vector<std::string>* params, size_t offset, std::vector<ConfigNode*>* result);
-    std::string pathNotFound(std::vector<std::string>* params);
+    std::atomic<const std::string*> filename; /**< Points into filenames, so lookups may keep the reference across reloads */
+    std::vector<std::unique_ptr<const std::string>> filenames; /**< Every name this configuration has had, protected by rootMutex */
+    std::string overlayFilename; /**< Host-specific file, whose keys override the ones of filename */
+    void collect(ConfigNode* node, const ConfigPath& path, size_t offset, std::vector<ConfigNode*>* result);
+    ConfigNode* findFirst(ConfigNode* node, const ConfigPath& path, size_t offset);
+    void collectSections(ConfigNode* node, const ConfigPath& path, size_t offset, std::vector<ConfigNode*>* result);
+    std::string pathNotFound(const ConfigPath& path);
 
     ConfigNodePtr configRoot;
+    ConfigNodePtr overlayRoot; /**< Keys of overlayFilename and the ones changed by set(), which is what store() writes */
+    bool lazyLoading; /**< Top-level sections are parsed on first access */
+    std::atomic<bool> dirty; /**< Changed by set() since it was loaded or stored */
+    std::atomic<bool> sharedRoot; /**< The tree is shared with other configurations, see loadShared() */
+    std::mutex rootMutex;         /**< Serialises replacing configRoot together with sharedRoot */
+
+    static void parse(const std::string& filename, std::istream& content, ConfigNode* node, int firstLine);
+    static ConfigNodePtr parseLazy(const std::string& filename, std::shared_ptr<const std::string> text);
+    ConfigNodePtr parseContent(const std::string& filename, std::shared_ptr<std::istream> content);
+    static void merge(ConfigNode* target, ConfigNode* overlay);
+    void publish(ConfigNodePtr root, bool shared = false);
+    void setFilename(const std::string& filename);
+    void detachRoot();
+    void updateOverlay(const std::vector<ConfigNode*>& nodes);
+    void write(const std::string& filename, ConfigNode* root);
 
-    void serialize_internal(std::ostringstream* ss, ConfigNode* node);
-    void serialize_without_root(std::ostringstream* ss, ConfigNode* node);
+    /**
+     * Returns the current configuration tree. The returned pointer keeps the tree alive,
+     * so a concurrent reload never frees nodes a reader is still working on.
+     */
+    ConfigNodePtr getRoot() const { return std::atomic_load(&this->configRoot); }
+
+    std::mutex bindingsMutex;
+    std::vector<std::weak_ptr<ConfigBinding>> bindings; /**< Parameters and structs, which follow changes of this configuration */
+    void addBinding(std::shared_ptr<ConfigBinding> binding);
+    void refreshBindings();
+
+    void serialize_internal(std::ostream* ss, ConfigNode* node, bool copyUnparsed = false);
+    void serialize_without_root(std::ostream* ss, ConfigNode* node, bool copyUnparsed = false);
 
     template <typename Target>
     Target convert(std::string value)
@@ -40,6 +96,20 @@ protected:
 
     template <typename Target>
     std::vector<Target> convertList(std::string value)
+    {
+        return convertList<Target>(value, std::integral_constant<bool, std::is_arithmetic<Target>::value && !std::is_same<Target, bool>::value>());
+    }
+
+    template <typename Target>
+    std::vector<Target> convertList(const std::string& value, std::true_type /*numeric*/)
+    {
+        std::vector<Target> itemVector;
+        NumberListParser::parse(value, &itemVector);
+        return itemVector;
+    }
+
+    template <typename Target>
+    std::vector<Target> convertList(const std::string& value, std::false_type /*numeric*/)
     {
         std::string errMsg = "Configuration: List Type not handled! Value to be converted was: " + value;
         std::cerr << errMsg << std::endl;
@@ -57,74 +127,202 @@ public:
     }
 
     void load(std::string filename, std::shared_ptr<std::istream> content, bool create, bool replace);
+    void load(std::string filename, std::string overlayFilename);
+    void loadShared(std::string filename);
+    bool reload();
+
+    const std::string& getFilename() const { return *this->filename.load(std::memory_order_acquire); }
+    const std::string& getOverlayFilename() const { return this->overlayFilename; }
+
+    /**
+     * In lazy mode, load() only indexes the top-level sections and each of them is parsed,
+     * when it is accessed for the first time. Syntax errors inside a section are reported on
+     * that access instead of by load(). Takes effect with the next load().
+     */
+    void setLazyLoading(bool lazy) { this->lazyLoading = lazy; }
+    bool isLazyLoading() const { return this->lazyLoading; }
+    bool isDirty() const { return this->dirty.load(); }
+    bool isShared() const { return this->sharedRoot.load(); }
 
     void store();
     void store(std::string filename);
 
     std::string serialize();
 
-    std::string trimLeft(const std::string& str, const std::string& whitespace = " \t");
+    static std::string trimLeft(const std::string& str, const std::string& whitespace = " \t");
     static std::string trim(const std::string& str, const std::string& whitespace = " \t");
     std::shared_ptr<std::vector<std::string>> getParams(char seperator, const char* path, va_list ap);
 
-    std::shared_ptr<std::vector<std::string>> getSections(const char* path, ...);
-    std::shared_ptr<std::vector<std::string>> tryGetSections(std::string d, const char* path, ...);
-    std::shared_ptr<std::vector<std::string>> getNames(const char* path, ...);
-    std::shared_ptr<std::vector<std::string>> tryGetNames(std::string d, const char* path, ...);
+    std::shared_ptr<std::vector<std::string>> getSections(const ConfigPath& path);
+    std::shared_ptr<std::vector<std::string>> getSections(const char* path);
+    std::shared_ptr<std::vector<std::string>> getSections(const char* path, ConfigPathNext next, ...);
+    std::shared_ptr<std::vector<std::string>> tryGetSections(std::string d, const ConfigPath& path);
+    std::shared_ptr<std::vector<std::string>> tryGetSections(std::string d, const char* path);
+    std::shared_ptr<std::vector<std::string>> tryGetSections(std::string d, const char* path, ConfigPathNext next, ...);
+    std::shared_ptr<std::vector<std::string>> getNames(const ConfigPath& path);
+    std::shared_ptr<std::vector<std::string>> getNames(const char* path);
+    std::shared_ptr<std::vector<std::string>> getNames(const char* path, ConfigPathNext next, ...);
+    std::shared_ptr<std::vector<std::string>> tryGetNames(std::string d, const ConfigPath& path);
+    std::shared_ptr<std::vector<std::string>> tryGetNames(std::string d, const char* path);
+    std::shared_ptr<std::vector<std::string>> tryGetNames(std::string d, const char* path, ConfigPathNext next, ...);
+
+    template <typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    std::shared_ptr<std::vector<std::string>> getSections(Path&&... path)
+    {
+        return getSections(ConfigPath(std::forward<Path>(path)...));
+    }
+
+    template <typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    std::shared_ptr<std::vector<std::string>> tryGetSections(std::string d, Path&&... path)
+    {
+        return tryGetSections(d, ConfigPath(std::forward<Path>(path)...));
+    }
+
+    template <typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    std::shared_ptr<std::vector<std::string>> getNames(Path&&... path)
+    {
+        return getNames(ConfigPath(std::forward<Path>(path)...));
+    }
+
+    template <typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    std::shared_ptr<std::vector<std::string>> tryGetNames(std::string d, Path&&... path)
+    {
+        return tryGetNames(d, ConfigPath(std::forward<Path>(path)...));
+    }
 
     template <typename T>
-    T get(const char* path, ...)
+    ConfigParam<T> bind(const ConfigPath& path);
+
+    /**
+     * Resolves the given path once and returns a handle, which is read with a single atomic load
+     * and follows reloads and set() calls, e.g. bind<double>("Drive", "MaxSpeed").
+     */
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    ConfigParam<T> bind(Path&&... path)
     {
-        va_list ap;
-        va_start(ap, path);
-        std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
-        va_end(ap);
-        std::vector<ConfigNode*> nodes;
+        return bind<T>(ConfigPath(std::forward<Path>(path)...));
+    }
 
-        collect(this->configRoot.get(), params.get(), 0, &nodes);
+    template <typename S>
+    ConfigStruct<S> bindStruct(const std::vector<ConfigField<S>>& fields, const ConfigPath& section);
 
-        if (nodes.size() == 0) {
-            std::string errMsg = "SC-Conf: " + pathNotFound(params.get());
+    /**
+     * Binds the given fields of the struct S to the keys of the given section at once.
+     */
+    template <typename S, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    ConfigStruct<S> bindStruct(const std::vector<ConfigField<S>>& fields, Path&&... section)
+    {
+        return bindStruct<S>(fields, ConfigPath(std::forward<Path>(section)...));
+    }
+
+    template <typename T>
+    T get(const ConfigPath& path)
+    {
+        ConfigProfiler::Scope profile(this->getFilename(), path);
+        ConfigNodePtr root = this->getRoot();
+        ConfigNode* node = findFirst(root.get(), path, 0);
+
+        if (node == nullptr) {
+            profile.miss();
+            std::string errMsg = "SC-Conf: " + pathNotFound(path);
             std::cerr << errMsg << std::endl;
             throw std::runtime_error(errMsg);
         } else {
-            return convert<T>(nodes[0]->getValue());
+            return convert<T>(node->getValue());
         }
     }
 
+    /**
+     * Returns the value at the given path, e.g. get<int>("Globals", "Team", name, "ID").
+     * Segments may contain dots and a trailing NULL is accepted for compatibility.
+     */
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    T get(Path&&... path)
+    {
+        return get<T>(ConfigPath(std::forward<Path>(path)...));
+    }
+
     template <typename T>
-    std::vector<T> getList(const char* path, ...)
+    T get(const char* path, ConfigPathNext next, ...)
     {
         va_list ap;
-        va_start(ap, path);
-        std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
+        va_start(ap, next);
+        ConfigPath configPath(path, next, ap);
         va_end(ap);
-        std::vector<ConfigNode*> nodes;
+        return get<T>(configPath);
+    }
 
-        collect(this->configRoot.get(), params.get(), 0, &nodes);
+    template <typename T>
+    std::vector<T> getList(const ConfigPath& path)
+    {
+        ConfigProfiler::Scope profile(this->getFilename(), path);
+        ConfigNodePtr root = this->getRoot();
+        ConfigNode* node = findFirst(root.get(), path, 0);
 
-        if (nodes.size() == 0) {
-            std::string errMsg = "SC-Conf: " + pathNotFound(params.get());
+        if (node == nullptr) {
+            profile.miss();
+            std::string errMsg = "SC-Conf: " + pathNotFound(path);
             std::cerr << errMsg << std::endl;
             throw std::runtime_error(errMsg);
         } else {
-            return convertList<T>(nodes[0]->getValue());
+            return convertList<T>(node->getValue());
         }
     }
 
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    std::vector<T> getList(Path&&... path)
+    {
+        return getList<T>(ConfigPath(std::forward<Path>(path)...));
+    }
+
     template <typename T>
-    std::shared_ptr<std::vector<T>> getAll(const char* path, ...)
+    std::vector<T> getList(const char* path, ConfigPathNext next, ...)
     {
         va_list ap;
-        va_start(ap, path);
-        std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
+        va_start(ap, next);
+        ConfigPath configPath(path, next, ap);
         va_end(ap);
+        return getList<T>(configPath);
+    }
+
+    /**
+     * Parses a numeric list into the given buffer, e.g. a fixed-size lookup table.
+     * @return The number of elements written.
+     */
+    template <typename T>
+    size_t getList(T* buffer, size_t capacity, const ConfigPath& path)
+    {
+        ConfigProfiler::Scope profile(this->getFilename(), path);
+        ConfigNodePtr root = this->getRoot();
+        ConfigNode* node = findFirst(root.get(), path, 0);
+
+        if (node == nullptr) {
+            profile.miss();
+            std::string errMsg = "SC-Conf: " + pathNotFound(path);
+            std::cerr << errMsg << std::endl;
+            throw std::runtime_error(errMsg);
+        }
+        return NumberListParser::parse(node->getValue(), buffer, capacity);
+    }
+
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    size_t getList(T* buffer, size_t capacity, Path&&... path)
+    {
+        return getList<T>(buffer, capacity, ConfigPath(std::forward<Path>(path)...));
+    }
+
+    template <typename T>
+    std::shared_ptr<std::vector<T>> getAll(const ConfigPath& path)
+    {
+        ConfigProfiler::Scope profile(this->getFilename(), path);
         std::vector<ConfigNode*> nodes;
 
-        collect(this->configRoot.get(), params.get(), 0, &nodes);
+        ConfigNodePtr root = this->getRoot();
+        collect(root.get(), path, 0, &nodes);
 
         if (nodes.size() == 0) {
-            std::string errMsg = "SC-Conf: " + pathNotFound(params.get());
+            profile.miss();
+            std::string errMsg = "SC-Conf: " + pathNotFound(path);
             std::cerr << errMsg << std::endl;
             throw std::runtime_error(errMsg);
         } else {
@@ -138,41 +336,66 @@ public:
         }
     }
 
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    std::shared_ptr<std::vector<T>> getAll(Path&&... path)
+    {
+        return getAll<T>(ConfigPath(std::forward<Path>(path)...));
+    }
+
     template <typename T>
-    T tryGet(T d, const char* path, ...)
+    std::shared_ptr<std::vector<T>> getAll(const char* path, ConfigPathNext next, ...)
     {
         va_list ap;
-        va_start(ap, path);
-        std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
+        va_start(ap, next);
+        ConfigPath configPath(path, next, ap);
         va_end(ap);
+        return getAll<T>(configPath);
+    }
 
-        std::vector<ConfigNode*> nodes;
-
-        collect(this->configRoot.get(), params.get(), 0, &nodes);
+    template <typename T>
+    T tryGet(T d, const ConfigPath& path)
+    {
+        ConfigProfiler::Scope profile(this->getFilename(), path);
+        ConfigNodePtr root = this->getRoot();
+        ConfigNode* node = findFirst(root.get(), path, 0);
 
-        if (nodes.size() == 0) {
+        if (node == nullptr) {
+            profile.miss();
             return d;
         }
 
-        return convert<T>(nodes[0]->getValue());
+        return convert<T>(node->getValue());
+    }
+
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    T tryGet(T d, Path&&... path)
+    {
+        return tryGet<T>(d, ConfigPath(std::forward<Path>(path)...));
     }
 
     template <typename T>
-    std::shared_ptr<std::vector<T>> tryGetAll(T d, const char* path, ...)
+    T tryGet(T d, const char* path, ConfigPathNext next, ...)
     {
         va_list ap;
-        va_start(ap, path);
-        std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
+        va_start(ap, next);
+        ConfigPath configPath(path, next, ap);
         va_end(ap);
+        return tryGet<T>(d, configPath);
+    }
 
+    template <typename T>
+    std::shared_ptr<std::vector<T>> tryGetAll(T d, const ConfigPath& path)
+    {
+        ConfigProfiler::Scope profile(this->getFilename(), path);
         std::vector<ConfigNode*> nodes;
 
-        collect(this->configRoot.get(), params.get(), 0, &nodes);
+        ConfigNodePtr root = this->getRoot();
+        collect(root.get(), path, 0, &nodes);
 
         std::shared_ptr<std::vector<T>> result(new std::vector<T>());
 
         if (nodes.size() == 0) {
-
+            profile.miss();
             result->push_back(d);
 
             return result;
@@ -185,60 +408,90 @@ public:
         return result;
     }
 
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    std::shared_ptr<std::vector<T>> tryGetAll(T d, Path&&... path)
+    {
+        return tryGetAll<T>(d, ConfigPath(std::forward<Path>(path)...));
+    }
+
     template <typename T>
-    void set(T value, const char* path, ...)
+    std::shared_ptr<std::vector<T>> tryGetAll(T d, const char* path, ConfigPathNext next, ...)
     {
         va_list ap;
-        va_start(ap, path);
-        std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
+        va_start(ap, next);
+        ConfigPath configPath(path, next, ap);
         va_end(ap);
+        return tryGetAll<T>(d, configPath);
+    }
 
+    template <typename T>
+    void set(T value, const ConfigPath& path)
+    {
+        this->detachRoot();
         std::vector<ConfigNode*> nodes;
 
-        collect(this->configRoot.get(), params.get(), 0, &nodes);
+        ConfigNodePtr root = this->getRoot();
+        collect(root.get(), path, 0, &nodes);
 
         for (int i = 0; i < nodes.size(); i++) {
             if (nodes[i]->getType() == ConfigNode::Leaf) {
                 nodes[i]->setValue(value);
             }
         }
+        this->updateOverlay(nodes);
+        this->dirty = true;
+        this->refreshBindings();
+    }
+
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    void set(T value, Path&&... path)
+    {
+        set<T>(value, ConfigPath(std::forward<Path>(path)...));
     }
 
-    /**
-     * This method creates the configuration parameter if it not already exists
-     */
     template <typename T>
-    void setCreateIfNotExistent(T value, const char* path, ...)
+    void set(T value, const char* path, ConfigPathNext next, ...)
     {
         va_list ap;
-        va_start(ap, path);
-        std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
+        va_start(ap, next);
+        ConfigPath configPath(path, next, ap);
         va_end(ap);
+        set<T>(value, configPath);
+    }
 
+    /**
+     * This method creates the configuration parameter if it not already exists
+     */
+    template <typename T>
+    void setCreateIfNotExistent(T value, const ConfigPath& path)
+    {
+        this->detachRoot();
+        std::vector<std::string> params = path.toVector();
         std::vector<ConfigNode*> nodes;
 
-        collect(this->configRoot.get(), params.get(), 0, &nodes);
+        ConfigNodePtr root = this->getRoot();
+        collect(root.get(), path, 0, &nodes);
         if (nodes.size() == 0) {
-            if (params.get()[0].size() > 0) {
+            if (params.size() > 0) {
                 std::vector<std::string> newParams;
-                for (int i = 0; i < params.get()[0].size(); i++) {
+                for (int i = 0; i < params.size(); i++) {
                     nodes.clear();
                     if (newParams.size() == 0) {
-                        collect(this->configRoot.get(), params.get(), 0, &nodes);
+                        collect(root.get(), path, 0, &nodes);
                         if (nodes.size() > 0) {
-                            newParams.push_back(params.get()[0].at(i));
+                            newParams.push_back(params.at(i));
                         } else {
                             break;
                         }
                     } else {
-                        newParams.push_back(params.get()[0].at(i));
-                        collect(this->configRoot.get(), &newParams, 0, &nodes);
+                        newParams.push_back(params.at(i));
+                        collect(root.get(), ConfigPath(newParams), 0, &nodes);
                         std::cout << "Size nodes: " << nodes.size() << "iteration:" << i << std::endl;
                         if (nodes.size() > 0) {
-                            newParams.push_back(params.get()[0].at(i));
+                            newParams.push_back(params.at(i));
                         } else {
                             newParams.pop_back();
-                            collect(this->configRoot.get(), &newParams, 0, &nodes);
+                            collect(root.get(), ConfigPath(newParams), 0, &nodes);
 
                             std::cout << " FINAL Size nodes: " << nodes.size() << "iteration:" << i << std::endl;
                             break;
@@ -246,7 +499,7 @@ public:
                     }
                 }
 
-                std::vector<std::string> newSubList(params.get()[0].begin() + newParams.size(), params.get()[0].end());
+                std::vector<std::string> newSubList(params.begin() + newParams.size(), params.end());
                 ConfigNode* currentNode = NULL;
                 for (const std::string& newNode : newSubList) {
                     if (currentNode == NULL) {
@@ -265,6 +518,28 @@ public:
                 nodes[i]->setValue(value);
             }
         }
+        // includes the created node
+        nodes.clear();
+        collect(root.get(), path, 0, &nodes);
+        this->updateOverlay(nodes);
+        this->dirty = true;
+        this->refreshBindings();
+    }
+
+    template <typename T, typename... Path, typename = typename std::enable_if<isConfigPath<Path...>::value>::type>
+    void setCreateIfNotExistent(T value, Path&&... path)
+    {
+        setCreateIfNotExistent<T>(value, ConfigPath(std::forward<Path>(path)...));
+    }
+
+    template <typename T>
+    void setCreateIfNotExistent(T value, const char* path, ConfigPathNext next, ...)
+    {
+        va_list ap;
+        va_start(ap, next);
+        ConfigPath configPath(path, next, ap);
+        va_end(ap);
+        setCreateIfNotExistent<T>(value, configPath);
     }
 };
 
@@ -353,18 +628,6 @@ inline bool Configuration::convert<bool>(std::string value)
     throw std::runtime_error(errMsg);
 }
 
-template <>
-inline std::vector<int> Configuration::convertList<int>(std::string value)
-{
-    std::istringstream ss(value);
-    std::string listItem;
-    std::vector<int> itemVector;
-    while (std::getline(ss, listItem, LIST_ELEMENT_SEPERATOR)) {
-        itemVector.push_back(stoi(trim(listItem, " ")));
-    }
-    return itemVector;
-}
-
 template <>
 inline std::vector<std::string> Configuration::convertList<std::string>(std::string value)
 {
@@ -377,3 +640,5 @@ inline std::vector<std::string> Configuration::convertList<std::string>(std::str
     return itemVector;
 }
 }
+
+#include "ConfigParam.h"
@@ -1,8 +1,8 @@
 #ifndef SUPPLEMENTARY_DATETIME_H
 #define SUPPLEMENTARY_DATETIME_H 1
 
-#include <cstring>
-#include <sys/time.h>
+#include "ClockSource.h"
+
 #include <time.h>
 
 #define EPOCH_ADJUST (62135596800LL)
@@ -30,22 +30,23 @@ public:
     {
     }
 
-    static inline DateTime getUtcNow()
-    {
-        struct timeval tv;
-        memset(&tv, 0, sizeof(tv));
-        gettimeofday(&tv, NULL);
-        return DateTime(((static_cast<unsigned long long>(tv.tv_sec) + EPOCH_ADJUST) * 1000000 + tv.tv_usec) * 10);
-    }
+    /**
+     * @return The current wall clock time with 100 ns resolution.
+     */
+    static inline DateTime getUtcNow() { return DateTime(getUtcNowC()); }
 
     static inline unsigned long long getUtcNowC()
     {
-        struct timeval tv;
-        memset(&tv, 0, sizeof(tv));
-        gettimeofday(&tv, NULL);
-        return (((static_cast<unsigned long long>(tv.tv_sec) + EPOCH_ADJUST) * 1000000 + tv.tv_usec) * 10);
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (static_cast<unsigned long long>(ts.tv_sec) + EPOCH_ADJUST) * 10000000 + ts.tv_nsec / 100;
     }
 
+    /**
+     * @return The current time of the given clock, e.g. ClockSource::REALTIME_COARSE for cheap logging timestamps.
+     */
+    static inline DateTime getNow(ClockSource::Clock clock) { return DateTime(ClockSource::getTicks(clock)); }
+
     inline long long getTicks() { return this->ticks; }
 };
 } // namespace essentials
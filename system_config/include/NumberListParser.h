@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace essentials
+{
+
+/**
+ * Parses comma-separated lists of integral or floating-point numbers, e.g. "1, 2, -3".
+ * The separators are counted first, so the result is written into memory that is
+ * allocated once. Elements may be surrounded by spaces, tabs and the carriage returns of
+ * CRLF line endings, an empty last element (trailing comma) is ignored.
+ */
+class NumberListParser
+{
+public:
+    static const char SEPERATOR = ',';
+
+    /**
+     * Counts the separators in the given range, using SSE2 if available.
+     */
+    static size_t countSeparators(const char* data, size_t length);
+
+    template <typename T>
+    static void parse(const std::string& value, std::vector<T>* result)
+    {
+        result->resize(countSeparators(value.data(), value.size()) + 1);
+        result->resize(parse(value, result->data(), result->size()));
+    }
+
+    /**
+     * Parses the given list into a caller-provided buffer.
+     * @return The number of parsed elements.
+     * @throws std::runtime_error, if an element is malformed, out of range or the buffer is too small.
+     */
+    template <typename T>
+    static size_t parse(const std::string& value, T* buffer, size_t capacity)
+    {
+        static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "NumberListParser: only numeric types are supported");
+
+        const char* pos = value.c_str();
+        const char* end = pos + value.size();
+        size_t count = 0;
+        pos = skipBlanks(pos);
+        while (pos != end) {
+            if (count == capacity) {
+                throw std::runtime_error("SC-Conf: List has more than " + std::to_string(capacity) + " elements: " + value);
+            }
+            const char* next = parseElement(pos, &buffer[count]);
+            if (next == pos) {
+                throw std::runtime_error("SC-Conf: Malformed list element in: " + value);
+            }
+            count++;
+            pos = skipBlanks(next);
+            if (pos == end) {
+                break;
+            }
+            if (*pos != SEPERATOR) {
+                throw std::runtime_error("SC-Conf: Malformed list element in: " + value);
+            }
+            pos = skipBlanks(pos + 1);
+        }
+        return count;
+    }
+
+private:
+    static const char* skipBlanks(const char* pos)
+    {
+        while (*pos == ' ' || *pos == '\t' || *pos == '\r') {
+            pos++;
+        }
+        return pos;
+    }
+
+    static const char* parseElement(const char* pos, float* result);
+    static const char* parseElement(const char* pos, double* result);
+    static const char* parseElement(const char* pos, long double* result);
+
+    /**
+     * Parses a decimal integer without going through a locale or an intermediate string.
+     * @return The position after the element or pos, if there is no valid number.
+     */
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value, const char*>::type parseElement(const char* pos, T* result)
+    {
+        typedef typename std::make_unsigned<T>::type Magnitude;
+
+        const char* start = pos;
+        bool negative = false;
+        if (*pos == '-' || *pos == '+') {
+            negative = *pos == '-';
+            pos++;
+        }
+        if (negative && std::is_unsigned<T>::value) {
+            throw std::runtime_error("SC-Conf: Negative value for unsigned list element");
+        }
+        Magnitude limit = static_cast<Magnitude>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+        Magnitude magnitude = 0;
+        const char* begin = pos;
+        for (; *pos >= '0' && *pos <= '9'; pos++) {
+            Magnitude digit = static_cast<Magnitude>(*pos - '0');
+            if (magnitude > (limit - digit) / 10) {
+                throw std::out_of_range("SC-Conf: List element out of range");
+            }
+            magnitude = magnitude * 10 + digit;
+        }
+        if (pos == begin) {
+            return start;
+        }
+        *result = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+        return pos;
+    }
+};
+} // namespace essentials
@@ -1,37 +1,50 @@
 #pragma once
 
+#include "ConfigContext.h"
 #include "Configuration.h"
 
 #include <FileSystem.h>
 
 #include <atomic>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 const std::string DOMAIN_FOLDER = "DOMAIN_FOLDER";
 const std::string DOMAIN_CONFIG_FOLDER = "DOMAIN_CONFIG_FOLDER";
+const std::string CONFIG_PROFILE = "CONFIG_PROFILE";
 
 namespace essentials
 {
+class ConfigWatcher;
+
 class SystemConfig
 {
 
 protected:
     static std::string rootPath;
     static std::string logPath;
-    static std::string configPath;
-    static std::string hostname;
-    static std::mutex configsMapMutex;
-    static std::map<std::string, std::shared_ptr<Configuration>> configs;
+    static std::unique_ptr<ConfigContext> defaultContext;
     static const char NODE_NAME_SEPERATOR = '_';
 
+    static std::mutex watcherMutex;
+    static ConfigWatcher* watcher;
+    static std::mutex callbacksMutex;
+    static int nextCallbackId;
+    static std::map<std::string, std::map<int, std::function<void(Configuration*)>>> changeCallbacks;
+
+    static void updateWatchedFolders();
+    static void onConfigFileChanged(const std::string& folder, const std::string& file);
+
 public:
     static SystemConfig* getInstance();
+    static ConfigContext* getContext();
     static void shutdown();
     static std::string robotNodeName(const std::string& nodeName);
     static int getOwnRobotID();
@@ -48,8 +61,16 @@ public:
     void setConfigPath(std::string configPath);
     static std::string getEnv(const std::string& var);
 
+    static size_t preload(unsigned int threads = 0);
+    static void setLazyLoading(bool lazy);
+
+    static void enableLiveReload();
+    static void disableLiveReload();
+    static int registerChangeCallback(const std::string& configName, std::function<void(Configuration*)> callback);
+    static void unregisterChangeCallback(int callbackId);
+
 private:
     SystemConfig();
-    ~SystemConfig(){};
+    ~SystemConfig();
 };
 }
@@ -0,0 +1,97 @@
+#include "ClockSource.h"
+
+#include <iostream>
+
+#ifdef SC_HAVE_TSC
+#include <cpuid.h>
+#endif
+
+namespace essentials
+{
+#ifdef SC_HAVE_TSC
+namespace
+{
+/**
+ * Reads CLOCK_MONOTONIC and the TSC value at the middle of that read.
+ */
+int64_t readClockAndTsc(uint64_t* tsc)
+{
+    uint64_t before = __rdtsc();
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t after = __rdtsc();
+    *tsc = before + (after - before) / 2;
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+} // namespace
+#endif
+
+/**
+ * @return True, if the time stamp counter runs at a constant rate in all power states.
+ */
+bool ClockSource::hasInvariantTsc()
+{
+#ifdef SC_HAVE_TSC
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return (edx & (1u << 8)) != 0;
+    }
+#endif
+    return false;
+}
+
+/**
+ * @return The calibrated ticks per second of the time stamp counter or 0, if the TSC clock falls back to MONOTONIC.
+ */
+double ClockSource::getTscFrequency()
+{
+    const TscCalibration& calibration = getTscCalibration();
+    return calibration.tsc ? 1e9 / calibration.nanosPerTscTick : 0.0;
+}
+
+ClockSource::EpochOffsets ClockSource::measureEpochOffsets()
+{
+    EpochOffsets epochOffsets;
+    epochOffsets.offsets[REALTIME] = 0;
+    epochOffsets.offsets[REALTIME_COARSE] = 0;
+    epochOffsets.offsets[MONOTONIC] = readClock(CLOCK_REALTIME) - readClock(CLOCK_MONOTONIC);
+    epochOffsets.offsets[MONOTONIC_COARSE] = readClock(CLOCK_REALTIME) - readClock(CLOCK_MONOTONIC_COARSE);
+    // the TSC clock is converted to CLOCK_MONOTONIC nanoseconds
+    epochOffsets.offsets[TSC] = epochOffsets.offsets[MONOTONIC];
+    return epochOffsets;
+}
+
+ClockSource::TscCalibration ClockSource::calibrateTsc()
+{
+    TscCalibration calibration;
+    calibration.tsc = false;
+    calibration.tscStart = 0;
+    calibration.tscStartNanos = 0;
+    calibration.nanosPerTscTick = 0.0;
+
+#ifdef SC_HAVE_TSC
+    if (!hasInvariantTsc()) {
+        std::cerr << "SC-Clock: No invariant TSC, falling back to CLOCK_MONOTONIC" << std::endl;
+        return calibration;
+    }
+
+    // count the TSC ticks during 20 ms of CLOCK_MONOTONIC
+    uint64_t tscStart;
+    int64_t nanosStart = readClockAndTsc(&tscStart);
+    struct timespec wait = {0, 20000000};
+    nanosleep(&wait, nullptr);
+    uint64_t tscEnd;
+    int64_t nanosEnd = readClockAndTsc(&tscEnd);
+    if (tscEnd <= tscStart || nanosEnd <= nanosStart) {
+        std::cerr << "SC-Clock: Could not calibrate the TSC, falling back to CLOCK_MONOTONIC" << std::endl;
+        return calibration;
+    }
+
+    calibration.tsc = true;
+    calibration.tscStart = tscEnd;
+    calibration.tscStartNanos = nanosEnd;
+    calibration.nanosPerTscTick = static_cast<double>(nanosEnd - nanosStart) / (tscEnd - tscStart);
+#endif
+    return calibration;
+}
+} // namespace essentials
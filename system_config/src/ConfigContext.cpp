@@ -0,0 +1,320 @@
+#include "ConfigContext.h"
+
+#include <FileSystem.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+namespace essentials
+{
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::mutex;
+using std::string;
+using std::vector;
+
+ConfigContext::ConfigContext(const std::string& configPath, const std::string& hostname)
+        : configPath(configPath)
+        , hostname(hostname)
+        , lazyLoading(false)
+{
+    for (auto& bucket : this->buckets) {
+        bucket.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ConfigContext::~ConfigContext() {}
+
+/**
+ * Returns the configuration with the given name, e.g. "Globals" for Globals.conf.
+ * Configurations that are already loaded (or known to be missing) are found without locking.
+ * @return The configuration or nullptr, if neither the host-specific nor the global file exists.
+ */
+Configuration* ConfigContext::operator[](const std::string& configName)
+{
+    ConfigEntry* entry = findEntry(configName);
+    if (entry == nullptr) {
+        entry = getOrCreateEntry(configName);
+    }
+    if (!entry->loaded.load(std::memory_order_acquire)) {
+        std::call_once(entry->loadOnce, &ConfigContext::loadEntry, this, std::cref(configName), entry);
+    }
+    return entry->config.get();
+}
+
+std::string ConfigContext::getConfigPath() const
+{
+    std::lock_guard<mutex> lock(this->pathsMutex);
+    return this->configPath;
+}
+
+/**
+ * Changes the config folder. Loaded configurations are kept, but files that were missing so far
+ * are looked up again.
+ */
+void ConfigContext::setConfigPath(const std::string& configPath)
+{
+    {
+        std::lock_guard<mutex> lock(this->pathsMutex);
+        this->configPath = configPath;
+    }
+    forgetMissingConfigs();
+}
+
+std::string ConfigContext::getHostname() const
+{
+    std::lock_guard<mutex> lock(this->pathsMutex);
+    return this->hostname;
+}
+
+/**
+ * Changes the host, whose files overlay the global ones. All configurations are loaded again on their next access.
+ */
+void ConfigContext::setHostname(const std::string& hostname)
+{
+    {
+        std::lock_guard<mutex> lock(this->pathsMutex);
+        this->hostname = hostname;
+    }
+    clearConfigs();
+}
+
+/**
+ * Configurations loaded after this call only parse their top-level sections on first access.
+ * Helps processes, which read a few keys of large shared configuration files.
+ */
+void ConfigContext::setLazyLoading(bool lazy)
+{
+    this->lazyLoading = lazy;
+}
+
+/**
+ * @return The config folder and the host-specific subfolder.
+ */
+std::vector<std::string> ConfigContext::getFolders() const
+{
+    std::lock_guard<mutex> lock(this->pathsMutex);
+    vector<string> folders;
+    folders.push_back(this->configPath);
+    folders.push_back(FileSystem::combinePaths(this->configPath, this->hostname));
+    return folders;
+}
+
+ConfigContext::ConfigSlot* ConfigContext::findSlot(const std::string& configName) const
+{
+    size_t bucket = std::hash<string>()(configName) % CONFIG_BUCKETS;
+    for (ConfigSlot* slot = this->buckets[bucket].load(std::memory_order_acquire); slot != nullptr; slot = slot->next) {
+        if (slot->name == configName) {
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+ConfigContext::ConfigEntry* ConfigContext::findEntry(const std::string& configName)
+{
+    ConfigSlot* slot = findSlot(configName);
+    return slot == nullptr ? nullptr : slot->entry.load(std::memory_order_acquire);
+}
+
+/**
+ * Adds an entry for the given name. Slots and entries are kept until the context is destroyed,
+ * so their number only grows with the configuration names and the reloads of the context.
+ */
+ConfigContext::ConfigEntry* ConfigContext::getOrCreateEntry(const std::string& configName)
+{
+    std::lock_guard<mutex> lock(this->configsMutex);
+    ConfigSlot* slot = findSlot(configName);
+    if (slot == nullptr) {
+        size_t bucket = std::hash<string>()(configName) % CONFIG_BUCKETS;
+        this->slots.emplace_back(new ConfigSlot(configName, this->buckets[bucket].load(std::memory_order_relaxed)));
+        slot = this->slots.back().get();
+        this->buckets[bucket].store(slot, std::memory_order_release);
+    }
+    ConfigEntry* entry = slot->entry.load(std::memory_order_relaxed);
+    if (entry == nullptr) { // another thread could have been faster
+        this->entries.emplace_back(new ConfigEntry());
+        entry = this->entries.back().get();
+        slot->entry.store(entry, std::memory_order_release);
+    }
+    return entry;
+}
+
+/**
+ * Loads the global config overlaid by the host-specific one or, if only one of them exists, that one.
+ * A missing file is reported once and remembered, until it shows up.
+ */
+void ConfigContext::loadEntry(const std::string& configName, ConfigEntry* entry)
+{
+    std::shared_ptr<Configuration> config = std::make_shared<Configuration>();
+    config->setLazyLoading(this->lazyLoading.load());
+    if (loadConfigFiles(config.get(), configName)) {
+        entry->config = config;
+        entry->loaded.store(true, std::memory_order_release);
+        return;
+    }
+
+    // config-file not found, print error message
+    string file = configName + ".conf";
+    vector<string> folders = this->getFolders();
+    cerr << "Configuration file " << file << " not found in either location:" << endl;
+    cerr << "- " << FileSystem::combinePaths(folders[1], file) << endl;
+    cerr << "- " << FileSystem::combinePaths(folders[0], file) << endl;
+    entry->loaded.store(true, std::memory_order_release);
+}
+
+/**
+ * Loads the files of the given config into the given configuration. Global files without
+ * a host-specific overlay are shared with the other contexts.
+ * @return false, if neither the host-specific nor the global file exists.
+ */
+bool ConfigContext::loadConfigFiles(Configuration* config, const std::string& configName)
+{
+    string file = configName + ".conf";
+    vector<string> folders = this->getFolders();
+    string globalFile = FileSystem::combinePaths(folders[0], file);
+    string hostFile = FileSystem::combinePaths(folders[1], file);
+
+    bool hostExists = FileSystem::pathExists(hostFile);
+    bool globalExists = FileSystem::pathExists(globalFile);
+    if (hostExists && globalExists) {
+        config->load(globalFile, hostFile);
+    } else if (hostExists) {
+        config->load(hostFile);
+    } else if (globalExists) {
+        config->loadShared(globalFile);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ConfigContext::clearConfigs()
+{
+    std::lock_guard<mutex> lock(this->configsMutex);
+    for (auto& slot : this->slots) {
+        slot->entry.store(nullptr, std::memory_order_release);
+    }
+}
+
+/**
+ * Drops the cache entries of all configuration files, which were not found.
+ */
+void ConfigContext::forgetMissingConfigs()
+{
+    std::lock_guard<mutex> lock(this->configsMutex);
+    for (auto& slot : this->slots) {
+        ConfigEntry* entry = slot->entry.load(std::memory_order_relaxed);
+        if (entry != nullptr && entry->loaded.load(std::memory_order_acquire) && !entry->config) {
+            slot->entry.store(nullptr, std::memory_order_release);
+        }
+    }
+}
+
+/**
+ * Loads all configuration files of the config folder and the host-specific subfolder in parallel,
+ * instead of lazily on first access. Files that fail to parse are reported and loaded again on
+ * first access, so the caller of operator[] still gets the parse error.
+ * @param threads The number of threads for parsing, 0 means one per hardware thread.
+ * @return The number of loaded configurations.
+ */
+size_t ConfigContext::preload(unsigned int threads)
+{
+    vector<string> folders = this->getFolders();
+    std::reverse(folders.begin(), folders.end());
+
+    vector<string> configNames;
+    for (const string& folder : folders) {
+        if (!FileSystem::isDirectory(folder)) {
+            continue;
+        }
+        for (const string& file : FileSystem::findAllFiles(folder, ".conf")) {
+            string configName = file.substr(file.find_last_of(FileSystem::PATH_SEPARATOR) + 1);
+            configName = configName.substr(0, configName.size() - string(".conf").size());
+            if (std::find(configNames.begin(), configNames.end(), configName) == configNames.end()) {
+                configNames.push_back(configName);
+            }
+        }
+    }
+    if (configNames.empty()) {
+        cerr << "SC: No configuration files found in \"" << folders.back() << "\"" << endl;
+        return 0;
+    }
+
+    vector<ConfigEntry*> entries;
+    for (const string& configName : configNames) {
+        ConfigEntry* entry = findEntry(configName);
+        entries.push_back(entry != nullptr ? entry : getOrCreateEntry(configName));
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, static_cast<unsigned int>(entries.size()));
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> loaded(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < entries.size(); i = next++) {
+            try {
+                if (!entries[i]->loaded.load(std::memory_order_acquire)) {
+                    std::call_once(entries[i]->loadOnce, &ConfigContext::loadEntry, this, std::cref(configNames[i]), entries[i]);
+                }
+                if (entries[i]->config) {
+                    loaded++;
+                }
+            } catch (std::exception& e) {
+                cerr << "SC: Could not preload " << configNames[i] << ".conf: " << e.what() << endl;
+            }
+        }
+    };
+
+    vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return loaded;
+}
+
+/**
+ * Reloads the configuration, which the given file belongs to, if it has been loaded by this context.
+ * @return The reloaded configuration or nullptr, if nothing has been reloaded.
+ */
+Configuration* ConfigContext::reloadFile(const std::string& folder, const std::string& file)
+{
+    string configName = file.substr(0, file.size() - string(".conf").size());
+    ConfigEntry* entry = findEntry(configName);
+    if (entry == nullptr || !entry->loaded.load(std::memory_order_acquire)) {
+        // not loaded yet, so the next access reads the new content anyway
+        return nullptr;
+    }
+    std::shared_ptr<Configuration> config = entry->config;
+    if (!config) {
+        // the file has been missing so far
+        forgetMissingConfigs();
+        return nullptr;
+    }
+
+    // both files may have been added or changed, so the layers are set up again
+    string changedFile = FileSystem::combinePaths(folder, file);
+    vector<string> folders = this->getFolders();
+    if (changedFile != FileSystem::combinePaths(folders[0], file) && changedFile != FileSystem::combinePaths(folders[1], file)) {
+        return nullptr;
+    }
+    try {
+        loadConfigFiles(config.get(), configName);
+    } catch (std::exception& e) {
+        cerr << "SC: Keeping the old content of " << configName << ", because it could not be reloaded!" << endl;
+        return nullptr;
+    }
+    cout << "SC: Reloaded " << changedFile << endl;
+    return config.get();
+}
+} // namespace essentials
@@ -0,0 +1,91 @@
+#include "ConfigPath.h"
+
+#include <sstream>
+
+namespace essentials
+{
+
+ConfigPath::ConfigPath(const std::vector<std::string>& segments)
+        : count(0)
+        , terminated(false)
+{
+    for (const std::string& segment : segments) {
+        this->add(ConfigPathSegment(segment.c_str(), segment.size()));
+    }
+}
+
+/**
+ * Compatibility layer for the NULL-terminated va_list API.
+ * @param path The first segment.
+ * @param next The second segment or NULL.
+ * @param ap The following segments, terminated by NULL.
+ */
+ConfigPath::ConfigPath(const char* path, ConfigPathNext next, va_list ap)
+        : count(0)
+        , terminated(false)
+{
+    if (path == NULL) {
+        return;
+    }
+    this->add(ConfigPathSegment(path, strlen(path)));
+    for (const char* segment = next.segment; segment != NULL; segment = va_arg(ap, const char*)) {
+        this->add(ConfigPathSegment(segment, strlen(segment)));
+    }
+}
+
+/**
+ * Appends the given segment and splits it, if it contains separators.
+ */
+void ConfigPath::add(const ConfigPathSegment& segment)
+{
+    if (this->terminated) {
+        return;
+    }
+    if (!segment.dotted) {
+        this->push(segment);
+        return;
+    }
+    const char* begin = segment.name;
+    const char* end = segment.name + segment.length;
+    while (true) {
+        const char* sep = static_cast<const char*>(memchr(begin, SEPERATOR, end - begin));
+        if (sep == nullptr) {
+            this->push(ConfigPathSegment(begin, end - begin));
+            return;
+        }
+        this->push(ConfigPathSegment(begin, sep - begin));
+        begin = sep + 1;
+    }
+}
+
+void ConfigPath::push(const ConfigPathSegment& segment)
+{
+    if (this->count < INLINE_SEGMENTS) {
+        this->inlineSegments[this->count] = segment;
+    } else {
+        this->moreSegments.push_back(segment);
+    }
+    this->count++;
+}
+
+std::vector<std::string> ConfigPath::toVector() const
+{
+    std::vector<std::string> segments;
+    for (size_t i = 0; i < this->count; i++) {
+        segments.emplace_back((*this)[i].name, (*this)[i].length);
+    }
+    return segments;
+}
+
+std::string ConfigPath::toString() const
+{
+    std::ostringstream os;
+    for (size_t i = 0; i < this->count; i++) {
+        if (i > 0) {
+            os << SEPERATOR;
+        }
+        os.write((*this)[i].name, (*this)[i].length);
+    }
+    return os.str();
+}
+} // namespace essentials
@@ -0,0 +1,220 @@
+#include "ConfigProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace essentials
+{
+
+std::atomic<bool> ConfigProfiler::enabled(false);
+std::mutex ConfigProfiler::statsMutex;
+ConfigProfiler::StatsMap ConfigProfiler::stats;
+std::mutex ConfigProfiler::dumpMutex;
+std::string ConfigProfiler::dumpFile;
+int ConfigProfiler::dumpSignal = 0;
+int ConfigProfiler::signalPipe[2] = {-1, -1};
+std::thread* ConfigProfiler::signalThread = nullptr;
+
+void ConfigProfiler::enable()
+{
+    enabled = true;
+}
+
+void ConfigProfiler::disable()
+{
+    enabled = false;
+}
+
+void ConfigProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.clear();
+}
+
+void ConfigProfiler::record(const std::string& file, const ConfigPath& path, bool missed, std::chrono::steady_clock::duration duration)
+{
+    uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    std::pair<std::string, std::string> key(file, path.toString());
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    Stats& entry = stats[key];
+    entry.count++;
+    entry.misses += missed ? 1 : 0;
+    entry.totalNanos += nanos;
+    entry.maxNanos = std::max(entry.maxNanos, nanos);
+}
+
+/**
+ * Returns the collected lookups, which took the most time in total first.
+ */
+static std::vector<std::pair<std::pair<std::string, std::string>, ConfigProfiler::Stats>> sortedStats(
+        const std::map<std::pair<std::string, std::string>, ConfigProfiler::Stats>& stats)
+{
+    std::vector<std::pair<std::pair<std::string, std::string>, ConfigProfiler::Stats>> sorted(stats.begin(), stats.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::pair<std::string, std::string>, ConfigProfiler::Stats>& a,
+                                                    const std::pair<std::pair<std::string, std::string>, ConfigProfiler::Stats>& b) {
+        return a.second.totalNanos > b.second.totalNanos;
+    });
+    return sorted;
+}
+
+std::string ConfigProfiler::report()
+{
+    StatsMap snapshot;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        snapshot = stats;
+    }
+
+    std::ostringstream os;
+    os << std::setw(10) << "count" << std::setw(10) << "misses" << std::setw(14) << "total[us]" << std::setw(12) << "avg[ns]" << std::setw(12) << "max[ns]"
+       << "  file:path" << std::endl;
+    for (auto& entry : sortedStats(snapshot)) {
+        const Stats& s = entry.second;
+        os << std::setw(10) << s.count << std::setw(10) << s.misses << std::setw(14) << s.totalNanos / 1000 << std::setw(12) << s.totalNanos / s.count
+           << std::setw(12) << s.maxNanos << "  " << entry.first.first << ":" << entry.first.second << std::endl;
+    }
+    return os.str();
+}
+
+static std::string jsonString(const std::string& str)
+{
+    std::ostringstream os;
+    os << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+    return os.str();
+}
+
+std::string ConfigProfiler::toJson()
+{
+    StatsMap snapshot;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        snapshot = stats;
+    }
+
+    std::ostringstream os;
+    os << "[" << std::endl;
+    bool first = true;
+    for (auto& entry : sortedStats(snapshot)) {
+        const Stats& s = entry.second;
+        os << (first ? "" : ",\n") << "  {\"file\": " << jsonString(entry.first.first) << ", \"path\": " << jsonString(entry.first.second)
+           << ", \"count\": " << s.count << ", \"misses\": " << s.misses << ", \"totalNanos\": " << s.totalNanos << ", \"maxNanos\": " << s.maxNanos << "}";
+        first = false;
+    }
+    os << std::endl << "]" << std::endl;
+    return os.str();
+}
+
+/**
+ * Writes the report to the given file, as JSON if the file name ends with ".json".
+ */
+bool ConfigProfiler::dump(const std::string& filename)
+{
+    bool json = filename.size() >= 5 && filename.compare(filename.size() - 5, 5, ".json") == 0;
+    std::ofstream os(filename.c_str(), std::ios_base::out);
+    os << (json ? toJson() : report());
+    if (!os.good()) {
+        std::cerr << "SC-Profiler: Could not write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Enables profiling and writes the report to the given file at shutdown.
+ * @param signal If not 0, the report is also written each time the process receives this signal.
+ */
+void ConfigProfiler::setDumpFile(const std::string& filename, int signal)
+{
+    std::lock_guard<std::mutex> lock(dumpMutex);
+    dumpFile = filename;
+    enable();
+    if (signal == 0 || signalThread != nullptr) {
+        return;
+    }
+    if (pipe2(signalPipe, O_CLOEXEC) != 0) {
+        std::cerr << "SC-Profiler: Could not create the signal pipe!" << std::endl;
+        return;
+    }
+    dumpSignal = signal;
+    signalThread = new std::thread(&ConfigProfiler::runSignalThread);
+    struct sigaction action;
+    action.sa_handler = &ConfigProfiler::onSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(signal, &action, nullptr);
+}
+
+/**
+ * Writes the report, if a dump file has been set, and stops the signal thread.
+ */
+void ConfigProfiler::shutdown()
+{
+    std::thread* thread;
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        thread = signalThread;
+        signalThread = nullptr;
+        filename = dumpFile;
+        if (thread != nullptr) {
+            signal(dumpSignal, SIG_DFL);
+            close(signalPipe[1]);
+            signalPipe[1] = -1;
+        }
+    }
+    // the signal thread takes the dumpMutex itself
+    if (thread != nullptr) {
+        thread->join();
+        delete thread;
+        close(signalPipe[0]);
+        signalPipe[0] = -1;
+    }
+    if (!filename.empty()) {
+        dump(filename);
+    }
+}
+
+/**
+ * Only wakes up the signal thread, as writing the report is not async-signal-safe.
+ */
+void ConfigProfiler::onSignal(int)
+{
+    char c = 'd';
+    if (write(signalPipe[1], &c, 1) < 0) {
+        // nothing sensible to do inside a signal handler
+    }
+}
+
+void ConfigProfiler::runSignalThread()
+{
+    char c;
+    // returns 0, when the write end is closed on shutdown
+    while (read(signalPipe[0], &c, 1) > 0) {
+        std::string filename;
+        {
+            std::lock_guard<std::mutex> lock(dumpMutex);
+            filename = dumpFile;
+        }
+        dump(filename);
+    }
+}
+} // namespace essentials
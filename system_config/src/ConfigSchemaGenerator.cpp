@@ -0,0 +1,238 @@
+/**
+ * Generates a C++ struct with a one-pass loader from a configuration schema.
+ *
+ * A schema is written like the .conf file it describes, but with the type of each key as its value:
+ *
+ *   maxSpeed = double
+ *   [Team]
+ *       names = list<string>
+ *   [!Team]
+ *
+ * Supported types are bool, string, short, int, long, long long, their unsigned variants, float,
+ * double, long double and list<T> of the numeric types or string. Each section becomes a nested
+ * struct <Section>Section held by a field named like the section.
+ *
+ * Usage: config_schema_generator <schema.conf> <output.h> <StructName> [namespace]
+ */
+#include "ConfigSchema.h"
+#include "Configuration.h"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+using essentials::ConfigNode;
+using essentials::ConfigNodePtr;
+
+const std::map<std::string, std::string> TYPES = {{"bool", "bool"}, {"string", "std::string"}, {"short", "short"},
+        {"unsigned short", "unsigned short"}, {"int", "int"}, {"unsigned int", "unsigned int"}, {"long", "long"}, {"unsigned long", "unsigned long"},
+        {"long long", "long long"}, {"unsigned long long", "unsigned long long"}, {"float", "float"}, {"double", "double"}, {"long double", "long double"}};
+
+std::string error(const std::string& schema, const std::string& message)
+{
+    return "SC-Schema: " + schema + ": " + message;
+}
+
+bool isIdentifier(const std::string& name)
+{
+    if (name.empty() || isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    for (char c : name) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @return The C++ type of the given schema type.
+ */
+std::string toCppType(const std::string& schema, const std::string& key, const std::string& type)
+{
+    auto itr = TYPES.find(type);
+    if (itr != TYPES.end()) {
+        return itr->second;
+    }
+    if (type.compare(0, 5, "list<") == 0 && type.back() == '>') {
+        std::string elementType = essentials::Configuration::trim(type.substr(5, type.size() - 6));
+        itr = TYPES.find(elementType);
+        if (itr != TYPES.end() && elementType != "bool") {
+            return "std::vector<" + itr->second + ">";
+        }
+    }
+    throw std::runtime_error(error(schema, "Unknown type \"" + type + "\" of " + key));
+}
+
+class Generator
+{
+public:
+    Generator(const std::string& schema)
+            : schema(schema)
+    {
+    }
+
+    /**
+     * Writes the struct of the given section including its nested sections and loader.
+     */
+    void writeStruct(std::ostream& os, ConfigNode* section, const std::string& structName, const std::string& indent, bool topLevel)
+    {
+        std::vector<ConfigNode*> entries;
+        for (const ConfigNodePtr& child : *section->getChildren()) {
+            if (child->getType() == ConfigNode::Comment) {
+                continue;
+            }
+            if (!isIdentifier(child->getName())) {
+                throw std::runtime_error(error(this->schema, "\"" + child->getName() + "\" is no valid C++ identifier"));
+            }
+            for (ConfigNode* entry : entries) {
+                if (entry->getName() == child->getName()) {
+                    throw std::runtime_error(error(this->schema, child->getName() + " is declared twice"));
+                }
+            }
+            entries.push_back(child.get());
+        }
+
+        os << indent << "struct " << structName << "\n" << indent << "{\n";
+        for (ConfigNode* entry : entries) {
+            if (entry->getType() == ConfigNode::Node) {
+                writeStruct(os, entry, entry->getName() + "Section", indent + "    ", false);
+                os << "\n";
+            }
+        }
+        for (ConfigNode* entry : entries) {
+            if (entry->getType() == ConfigNode::Node) {
+                os << indent << "    " << entry->getName() << "Section " << entry->getName() << ";\n";
+            } else {
+                os << indent << "    " << toCppType(this->schema, entry->getName(), entry->getValue()) << " " << entry->getName() << ";\n";
+            }
+        }
+
+        if (topLevel) {
+            os << "\n";
+            os << indent << "    /**\n";
+            os << indent << "     * Fills all fields in one pass over the tree of the given configuration.\n";
+            os << indent << "     * @throws std::runtime_error, if a key is missing or its value has the wrong type.\n";
+            os << indent << "     */\n";
+            os << indent << "    static " << structName << " load(essentials::Configuration* config)\n";
+            os << indent << "    {\n";
+            os << indent << "        " << structName << " result;\n";
+            os << indent << "        essentials::ConfigNodePtr root = essentials::ConfigSchema::getRoot(config);\n";
+            os << indent << "        result.fill(config, root.get());\n";
+            os << indent << "        return result;\n";
+            os << indent << "    }\n";
+        }
+        os << "\n";
+        writeFill(os, entries, indent + "    ");
+        os << indent << "};\n";
+    }
+
+private:
+    std::string schema;
+
+    void writeFill(std::ostream& os, const std::vector<ConfigNode*>& entries, const std::string& indent)
+    {
+        os << indent << "void fill(essentials::Configuration* config, essentials::ConfigNode* node)\n";
+        os << indent << "{\n";
+        if (entries.empty()) {
+            os << indent << "    (void) config;\n";
+            os << indent << "    (void) node;\n";
+            os << indent << "}\n";
+            return;
+        }
+
+        // the children are matched by the hashes of their names, siblings with equal hashes share a case
+        std::map<uint64_t, std::vector<size_t>> cases;
+        for (size_t i = 0; i < entries.size(); i++) {
+            cases[entries[i]->getNameHash()].push_back(i);
+        }
+
+        os << indent << "    bool found[" << entries.size() << "] = {};\n";
+        os << indent << "    for (const essentials::ConfigNodePtr& child : *node->getChildren()) {\n";
+        os << indent << "        switch (child->getNameHash()) {\n";
+        for (auto& entry : cases) {
+            os << indent << "        case 0x" << std::hex << entry.first << std::dec << "ULL:\n";
+            for (size_t i : entry.second) {
+                const std::string& name = entries[i]->getName();
+                os << indent << "            if (!found[" << i << "] && child->getName() == \"" << name << "\") {\n";
+                if (entries[i]->getType() == ConfigNode::Node) {
+                    os << indent << "                essentials::ConfigSchema::checkSection(config, child.get());\n";
+                    os << indent << "                this->" << name << ".fill(config, child.get());\n";
+                } else {
+                    os << indent << "                essentials::ConfigSchema::read(config, child.get(), &this->" << name << ");\n";
+                }
+                os << indent << "                found[" << i << "] = true;\n";
+                os << indent << "            }\n";
+            }
+            os << indent << "            break;\n";
+        }
+        os << indent << "        }\n";
+        os << indent << "    }\n";
+        os << indent << "    static const char* const names[] = {";
+        for (size_t i = 0; i < entries.size(); i++) {
+            os << (i == 0 ? "" : ", ") << "\"" << entries[i]->getName() << "\"";
+        }
+        os << "};\n";
+        os << indent << "    essentials::ConfigSchema::checkFound(config, node, names, found, " << entries.size() << ");\n";
+        os << indent << "}\n";
+    }
+};
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 4 || argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " <schema.conf> <output.h> <StructName> [namespace]" << std::endl;
+        return 1;
+    }
+    std::string schema = argv[1];
+    std::string output = argv[2];
+    std::string structName = argv[3];
+    std::string ns = (argc == 5 ? argv[4] : "");
+
+    std::ostringstream os;
+    try {
+        if (!isIdentifier(structName)) {
+            throw std::runtime_error(error(schema, "\"" + structName + "\" is no valid struct name"));
+        }
+        essentials::Configuration config(schema);
+        essentials::ConfigNodePtr root = essentials::ConfigSchema::getRoot(&config);
+
+        os << "// Generated by config_schema_generator from " << schema << ", do not edit.\n";
+        os << "#pragma once\n\n";
+        os << "#include <ConfigSchema.h>\n\n";
+        os << "#include <string>\n";
+        os << "#include <vector>\n\n";
+        if (!ns.empty()) {
+            os << "namespace " << ns << "\n{\n";
+        }
+        Generator(schema).writeStruct(os, root.get(), structName, "", true);
+        if (!ns.empty()) {
+            os << "} // namespace " << ns << "\n";
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // keeps the timestamp of an unchanged header, so its includers are not rebuilt
+    std::ifstream existing(output);
+    std::stringstream existingContent;
+    existingContent << existing.rdbuf();
+    if (existing.is_open() && existingContent.str() == os.str()) {
+        return 0;
+    }
+    std::ofstream out(output);
+    out << os.str();
+    if (!out) {
+        std::cerr << "SC-Schema: Could not write " << output << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "ConfigWatcher.h"
+
+#include <FileSystem.h>
+
+#include <iostream>
+#include <set>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace essentials
+{
+
+ConfigWatcher::ConfigWatcher(ChangeHandler handler)
+        : handler(handler)
+        , inotifyFd(-1)
+        , wakeupFd(-1)
+        , running(true)
+        , runThread(nullptr)
+{
+    this->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (this->inotifyFd < 0) {
+        std::cerr << "SC-Watcher: Could not initialise inotify!" << std::endl;
+        return;
+    }
+    this->wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    this->runThread = new std::thread(&ConfigWatcher::run, this);
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    this->running = false;
+    if (this->runThread) {
+        uint64_t one = 1;
+        if (write(this->wakeupFd, &one, sizeof(one)) < 0) {
+            std::cerr << "SC-Watcher: Could not wake up watcher thread!" << std::endl;
+        }
+        this->runThread->join();
+        delete this->runThread;
+    }
+    if (this->wakeupFd >= 0) {
+        close(this->wakeupFd);
+    }
+    if (this->inotifyFd >= 0) {
+        close(this->inotifyFd);
+    }
+}
+
+/**
+ * Replaces the set of watched folders. Folders that do not exist yet are
+ * picked up as soon as they are created inside another watched folder.
+ * @param folders The folders to watch.
+ */
+void ConfigWatcher::setFolders(const std::vector<std::string>& folders)
+{
+    std::lock_guard<std::mutex> lock(this->watchesMutex);
+    this->folders = folders;
+    for (auto& watch : this->watches) {
+        inotify_rm_watch(this->inotifyFd, watch.first);
+    }
+    this->watches.clear();
+    this->updateWatches();
+}
+
+void ConfigWatcher::updateWatches()
+{
+    if (this->inotifyFd < 0) {
+        return;
+    }
+    for (const std::string& folder : this->folders) {
+        bool watched = false;
+        for (auto& watch : this->watches) {
+            if (watch.second == folder) {
+                watched = true;
+                break;
+            }
+        }
+        if (watched || !FileSystem::isDirectory(folder)) {
+            continue;
+        }
+        int wd = inotify_add_watch(this->inotifyFd, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0) {
+            std::cerr << "SC-Watcher: Could not watch folder \"" << folder << "\"" << std::endl;
+            continue;
+        }
+        this->watches[wd] = folder;
+    }
+}
+
+void ConfigWatcher::run()
+{
+    alignas(struct inotify_event) char buffer[4096];
+    struct pollfd fds[2];
+    fds[0].fd = this->inotifyFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = this->wakeupFd;
+    fds[1].events = POLLIN;
+
+    while (this->running) {
+        if (poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if (!this->running) {
+            return;
+        }
+
+        // collect all changes of this batch first, so that a file written in several steps is only reported once
+        std::set<std::pair<std::string, std::string>> changes;
+        ssize_t len;
+        while ((len = read(this->inotifyFd, buffer, sizeof(buffer))) > 0) {
+            std::lock_guard<std::mutex> lock(this->watchesMutex);
+            for (char* ptr = buffer; ptr < buffer + len;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+                ptr += sizeof(struct inotify_event) + event->len;
+
+                auto watch = this->watches.find(event->wd);
+                if (watch == this->watches.end() || event->len == 0) {
+                    continue;
+                }
+                if (event->mask & IN_ISDIR) {
+                    // e.g. the host-specific folder has been created
+                    this->updateWatches();
+                } else if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && FileSystem::endsWith(event->name, ".conf")) {
+                    changes.insert(std::make_pair(watch->second, std::string(event->name)));
+                }
+            }
+        }
+
+        for (auto& change : changes) {
+            try {
+                this->handler(change.first, change.second);
+            } catch (std::exception& e) {
+                std::cerr << "SC-Watcher: Exception while handling change of " << change.second << ": " << e.what() << std::endl;
+            }
+        }
+    }
+}
+} // namespace essentials
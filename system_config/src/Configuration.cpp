@@ -1,40 +1,333 @@
 #include "Configuration.h"
+#include "ConfigParam.h"
+
+#include <FileSystem.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace essentials
 {
+namespace
+{
+/**
+ * Writes a stream to a file descriptor, so the file can be synced before it is renamed.
+ */
+class FileDescriptorBuffer : public std::streambuf
+{
+public:
+    explicit FileDescriptorBuffer(int fd)
+            : fd(fd)
+    {
+        this->setp(this->buffer, this->buffer + sizeof(this->buffer));
+    }
+
+    ~FileDescriptorBuffer() { this->sync(); }
+
+protected:
+    int overflow(int c)
+    {
+        if (this->sync() != 0) {
+            return traits_type::eof();
+        }
+        if (c != traits_type::eof()) {
+            *this->pptr() = traits_type::to_char_type(c);
+            this->pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync()
+    {
+        const char* pos = this->pbase();
+        while (pos < this->pptr()) {
+            ssize_t written = write(this->fd, pos, this->pptr() - pos);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            pos += written;
+        }
+        this->setp(this->buffer, this->buffer + sizeof(this->buffer));
+        return 0;
+    }
+
+private:
+    int fd;
+    char buffer[16384];
+};
+} // namespace
+
 Configuration::Configuration()
-        : filename()
+        : filename(nullptr)
         , configRoot(new ConfigNode("root"))
+        , lazyLoading(false)
+        , dirty(false)
+        , sharedRoot(false)
 {
+    this->setFilename("");
 }
 
 Configuration::Configuration(std::string filename)
-        : filename(filename)
+        : filename(nullptr)
         , configRoot(new ConfigNode("root"))
+        , lazyLoading(false)
+        , dirty(false)
+        , sharedRoot(false)
 {
+    this->setFilename(filename);
     load(filename);
 }
 
 Configuration::Configuration(std::string filename, const std::string content)
-        : filename(filename)
+        : filename(nullptr)
         , configRoot(new ConfigNode("root"))
+        , lazyLoading(false)
+        , dirty(false)
+        , sharedRoot(false)
 {
+    this->setFilename(filename);
     load(filename, std::shared_ptr<std::istream>(new std::istringstream(content)), false, false);
 }
 
+/**
+ * Parses the given content into a fresh tree, which replaces the current one as a whole.
+ * Concurrent readers keep working on the old tree until they are done with it.
+ */
 void Configuration::load(std::string filename, std::shared_ptr<std::istream> content, bool, bool)
 {
-    this->filename = filename;
+    ConfigNodePtr root = parseContent(filename, content);
 
-    int linePos = 0;
+    this->setFilename(filename);
+    this->overlayFilename.clear();
+    std::atomic_store(&this->overlayRoot, ConfigNodePtr());
+    this->publish(root);
+}
+
+/**
+ * Loads the given file and overrides its keys with the ones of the overlay file, e.g. the
+ * host-specific version of a global configuration. Sections and keys, which only exist in the
+ * overlay, are added. The result is a single tree, so lookups do not need to check both files.
+ */
+void Configuration::load(std::string filename, std::string overlayFilename)
+{
+    ConfigNodePtr root = parseContent(filename, std::make_shared<std::ifstream>(filename.c_str(), std::ifstream::in));
+    ConfigNodePtr overlay = parseContent(overlayFilename, std::make_shared<std::ifstream>(overlayFilename.c_str(), std::ifstream::in));
+    merge(root.get(), overlay.get());
+
+    this->setFilename(filename);
+    if (this->overlayFilename != overlayFilename) {
+        this->overlayFilename = overlayFilename;
+    }
+    std::atomic_store(&this->overlayRoot, overlay);
+    this->publish(root);
+}
+
+/**
+ * Like load(filename), but shares the tree with all other configurations, which loaded the same
+ * unchanged file this way, e.g. the global files of many simulated agents in one process.
+ * The first set() works on a private copy of the tree.
+ */
+void Configuration::loadShared(std::string filename)
+{
+    struct SharedTree
+    {
+        struct timespec modified;
+        off_t size;
+        std::weak_ptr<ConfigNode> root;
+    };
+    static std::mutex sharedTreesMutex;
+    static std::map<std::pair<std::string, bool>, SharedTree> sharedTrees;
+
+    struct stat fileStat;
+    if (stat(filename.c_str(), &fileStat) != 0) {
+        load(filename);
+        return;
+    }
+
+    ConfigNodePtr root;
+    {
+        std::lock_guard<std::mutex> lock(sharedTreesMutex);
+        SharedTree& shared = sharedTrees[std::make_pair(filename, this->lazyLoading)];
+        root = shared.root.lock();
+        if (!root || shared.modified.tv_sec != fileStat.st_mtim.tv_sec || shared.modified.tv_nsec != fileStat.st_mtim.tv_nsec ||
+                shared.size != fileStat.st_size) {
+            root = parseContent(filename, std::make_shared<std::ifstream>(filename.c_str(), std::ifstream::in));
+            shared.modified = fileStat.st_mtim;
+            shared.size = fileStat.st_size;
+            shared.root = root;
+        }
+    }
+
+    this->setFilename(filename);
+    this->overlayFilename.clear();
+    std::atomic_store(&this->overlayRoot, ConfigNodePtr());
+    this->publish(root, true);
+}
+
+/**
+ * Publishes the given name. Names are never freed, as lookups on other threads may still read the previous one,
+ * but each distinct name is only stored once.
+ */
+void Configuration::setFilename(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(this->rootMutex);
+    const std::string* current = this->filename.load(std::memory_order_relaxed);
+    if (current != nullptr && *current == filename) {
+        return;
+    }
+    for (auto& name : this->filenames) {
+        if (*name == filename) {
+            this->filename.store(name.get(), std::memory_order_release);
+            return;
+        }
+    }
+    this->filenames.emplace_back(new std::string(filename));
+    this->filename.store(this->filenames.back().get(), std::memory_order_release);
+}
+
+/**
+ * Replaces a shared tree by a private copy, before it is changed.
+ */
+void Configuration::detachRoot()
+{
+    if (!this->sharedRoot.load()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(this->rootMutex);
+    // the flag is only cleared after the copy is published, so concurrent writers wait for it here
+    if (this->sharedRoot.load()) {
+        std::atomic_store(&this->configRoot, this->getRoot()->clone());
+        this->sharedRoot = false;
+    }
+}
+
+ConfigNodePtr Configuration::parseContent(const std::string& filename, std::shared_ptr<std::istream> content)
+{
+    ConfigNodePtr root;
+    if (this->lazyLoading) {
+        std::shared_ptr<const std::string> text =
+                std::make_shared<const std::string>(std::istreambuf_iterator<char>(*content), std::istreambuf_iterator<char>());
+        root = parseLazy(filename, text);
+        if (!root) {
+            std::istringstream is(*text);
+            root = std::make_shared<ConfigNode>("root");
+            parse(filename, is, root.get(), 0);
+        }
+    } else {
+        root = std::make_shared<ConfigNode>("root");
+        parse(filename, *content, root.get(), 0);
+    }
+    return root;
+}
+
+/**
+ * @param shared true, if the tree is shared with other configurations and must be copied before set() changes it
+ */
+void Configuration::publish(ConfigNodePtr root, bool shared)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->rootMutex);
+        std::atomic_store(&this->configRoot, root);
+        this->sharedRoot = shared;
+    }
+    this->dirty = false;
+    this->refreshBindings();
+}
+
+/**
+ * Applies the values of the given nodes of the merged tree to the overlay tree, creating the
+ * keys and sections, which the overlay file does not have yet.
+ */
+void Configuration::updateOverlay(const std::vector<ConfigNode*>& nodes)
+{
+    ConfigNodePtr overlay = std::atomic_load(&this->overlayRoot);
+    if (!overlay) {
+        return;
+    }
+    for (ConfigNode* node : nodes) {
+        if (node->getType() != ConfigNode::Leaf) {
+            continue;
+        }
+        std::vector<ConfigNode*> path;
+        for (ConfigNode* pathNode = node; pathNode->getParent() != nullptr; pathNode = pathNode->getParent()) {
+            path.push_back(pathNode);
+        }
+
+        ConfigNode* target = overlay.get();
+        for (auto itr = path.rbegin(); itr != path.rend(); itr++) {
+            ConfigNode* child = nullptr;
+            for (const ConfigNodePtr& candidate : *target->getChildren()) {
+                if (candidate->getType() == (*itr)->getType() && candidate->getName() == (*itr)->getName()) {
+                    child = candidate.get();
+                    break;
+                }
+            }
+            if (child == nullptr) {
+                child = (*itr)->getType() == ConfigNode::Leaf ? target->create((*itr)->getName(), (*itr)->getValue()) : target->create((*itr)->getName());
+            }
+            target = child;
+        }
+        target->setValue(node->getValue());
+    }
+}
+
+/**
+ * Copies the keys and sections of overlay into target. Keys, which already exist, get the
+ * value of the overlay. Comments of the overlay are dropped.
+ */
+void Configuration::merge(ConfigNode* target, ConfigNode* overlay)
+{
+    std::vector<ConfigNodePtr>* targetChildren = target->getChildren();
+    size_t targetSize = targetChildren->size(); // only match against the original children
+    for (const ConfigNodePtr& child : *overlay->getChildren()) {
+        if (child->getType() == ConfigNode::Comment) {
+            continue;
+        }
+        ConfigNodePtr existing;
+        for (size_t i = 0; i < targetSize; i++) {
+            if ((*targetChildren)[i]->getType() == child->getType() && (*targetChildren)[i]->getName() == child->getName()) {
+                existing = (*targetChildren)[i];
+                break;
+            }
+        }
+
+        if (child->getType() == ConfigNode::Leaf) {
+            if (existing) {
+                existing->setValue(child->getValue());
+            } else {
+                target->create(child->getName(), child->getValue());
+            }
+        } else {
+            merge(existing ? existing.get() : target->create(child->getName()), child.get());
+        }
+    }
+}
+
+/**
+ * Parses the given content into the children of the given node.
+ * @param firstLine The number of lines before the content, for error messages.
+ */
+void Configuration::parse(const std::string& filename, std::istream& content, ConfigNode* node, int firstLine)
+{
+    int linePos = firstLine;
     int chrPos = 0;
 
     std::string line;
 
-    ConfigNode* currentNode = this->configRoot.get();
+    ConfigNode* currentNode = node;
 
-    while (content->good()) {
-        getline(*content, line);
+    while (content.good()) {
+        getline(content, line);
         line = Configuration::trimLeft(line);
 
         int lineLen = line.length(); // size();
@@ -151,13 +444,191 @@ void Configuration::load(std::string filename, std::shared_ptr<std::istream> con
         }
     }
 
-    if (this->configRoot.get() != currentNode) {
+    if (node != currentNode) {
         std::cout << "Parse error in " << filename << ", line " << linePos << " character " << line.size() << ": no closing tag found!" << std::endl;
         throw std::exception();
     }
 }
 
-void Configuration::serialize_internal(std::ostringstream* ss, ConfigNode* node)
+/**
+ * Classifies a line of a configuration file for the section index.
+ * @return 0 for no tag, 1 for an opening tag, -1 for a closing tag and 2 for anything the
+ * index does not handle, like several tags on a single line.
+ */
+static int classifyTagLine(const std::string& text, size_t begin, size_t end, std::string* name)
+{
+    while (begin < end && (text[begin] == ' ' || text[begin] == '\t')) {
+        begin++;
+    }
+    if (begin == end || (text[begin] != '[' && text[begin] != '<')) {
+        return 0;
+    }
+    size_t tagEnd = text.find(']', begin);
+    if (tagEnd >= end) {
+        tagEnd = text.find('>', begin);
+    }
+    if (tagEnd >= end || tagEnd == begin + 1) {
+        return 2;
+    }
+    for (size_t i = tagEnd + 1; i < end; i++) {
+        if (text[i] != ' ' && text[i] != '\t' && text[i] != '\r') {
+            return 2;
+        }
+    }
+    name->assign(text, begin + 1, tagEnd - begin - 1);
+    return ((*name)[0] == '/' || (*name)[0] == '!') ? -1 : 1;
+}
+
+/**
+ * Builds a tree, whose top-level sections are only parsed when they are accessed for the first time.
+ * Keys and comments outside of sections are parsed right away.
+ * @return The new tree or nullptr, if the content has to be parsed eagerly, e.g. because of a syntax error.
+ */
+ConfigNodePtr Configuration::parseLazy(const std::string& filename, std::shared_ptr<const std::string> text)
+{
+    ConfigNodePtr root = std::make_shared<ConfigNode>("root");
+    size_t chunkBegin = 0;
+    int chunkLine = 0;
+    int linePos = 0;
+    size_t pos = 0;
+    std::string name;
+
+    while (pos < text->size()) {
+        size_t lineEnd = std::min(text->find('\n', pos), text->size());
+        size_t lineBegin = pos;
+        pos = lineEnd + 1;
+        if (text->find_first_not_of(" \t", lineBegin) < lineEnd) {
+            linePos++;
+        }
+
+        int tag = classifyTagLine(*text, lineBegin, lineEnd, &name);
+        if (tag == 0) {
+            continue;
+        } else if (tag != 1) {
+            return nullptr;
+        }
+
+        // find the matching closing tag
+        std::string sectionName = name;
+        size_t sectionBegin = lineBegin;
+        size_t bodyBegin = std::min(pos, text->size());
+        int bodyLine = linePos;
+        int nesting = 1;
+        size_t bodyEnd = std::string::npos;
+        while (pos < text->size()) {
+            lineEnd = std::min(text->find('\n', pos), text->size());
+            lineBegin = pos;
+            pos = lineEnd + 1;
+            if (text->find_first_not_of(" \t", lineBegin) < lineEnd) {
+                linePos++;
+            }
+            tag = classifyTagLine(*text, lineBegin, lineEnd, &name);
+            if (tag == 2) {
+                return nullptr;
+            }
+            nesting += tag;
+            if (nesting == 0) {
+                if (name.compare(1, std::string::npos, sectionName) != 0) {
+                    return nullptr;
+                }
+                bodyEnd = lineBegin;
+                break;
+            }
+        }
+        if (bodyEnd == std::string::npos) {
+            return nullptr;
+        }
+
+        // keys and comments between the previous section and this one
+        if (chunkBegin < sectionBegin) {
+            std::istringstream is(text->substr(chunkBegin, sectionBegin - chunkBegin));
+            parse(filename, is, root.get(), chunkLine);
+        }
+        root->createLazy(sectionName,
+                [filename, bodyLine](ConfigNode* section, const std::string& content) {
+                    std::istringstream is(content);
+                    parse(filename, is, section, bodyLine);
+                },
+                text, bodyBegin, bodyEnd);
+        chunkBegin = std::min(pos, text->size());
+        chunkLine = linePos;
+    }
+
+    if (chunkBegin < text->size()) {
+        std::istringstream is(text->substr(chunkBegin));
+        parse(filename, is, root.get(), chunkLine);
+    }
+    return root;
+}
+
+/**
+ * Re-parses the file this configuration was loaded from. On parse errors the current tree is kept.
+ * @return true if the new content has been published, false otherwise.
+ */
+bool Configuration::reload()
+{
+    std::string filename = this->getFilename();
+    if (filename.empty()) {
+        return false;
+    }
+    try {
+        if (this->overlayFilename.empty()) {
+            load(filename);
+        } else {
+            load(filename, this->overlayFilename);
+        }
+    } catch (std::exception& e) {
+        std::cerr << "SC-Conf: Keeping the old content of " << filename << ", because it could not be reloaded!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Resolves the binding for the first time and registers it for later updates.
+ */
+void Configuration::addBinding(std::shared_ptr<ConfigBinding> binding)
+{
+    std::lock_guard<std::mutex> lock(this->bindingsMutex);
+    if (!binding->refresh(this, this->getRoot().get())) {
+        std::string errMsg = "SC-Conf: " + pathNotFound(ConfigPath(binding->getPath()));
+        std::cerr << errMsg << std::endl;
+        throw std::runtime_error(errMsg);
+    }
+    this->bindings.push_back(binding);
+}
+
+/**
+ * Publishes the current values to all bindings and drops the ones, which are not used anymore.
+ * Bindings, whose path disappeared, keep their last value.
+ */
+void Configuration::refreshBindings()
+{
+    std::lock_guard<std::mutex> lock(this->bindingsMutex);
+    if (this->bindings.empty()) {
+        return;
+    }
+    ConfigNodePtr root = this->getRoot();
+    for (auto itr = this->bindings.begin(); itr != this->bindings.end();) {
+        std::shared_ptr<ConfigBinding> binding = itr->lock();
+        if (!binding) {
+            itr = this->bindings.erase(itr);
+            continue;
+        }
+        // the new tree is already published, so a binding, which cannot convert its value, keeps the old one
+        try {
+            if (!binding->refresh(this, root.get())) {
+                std::cerr << "SC-Conf: Keeping the last value of " << pathNotFound(ConfigPath(binding->getPath()));
+            }
+        } catch (std::exception& e) {
+            std::cerr << "SC-Conf: Keeping the last value of '" << ConfigPath(binding->getPath()).toString() << "' in " << this->getFilename() << ": " << e.what()
+                      << std::endl;
+        }
+        itr++;
+    }
+}
+
+void Configuration::serialize_internal(std::ostream* ss, ConfigNode* node, bool copyUnparsed)
 {
     if (node == NULL)
         return;
@@ -165,8 +636,11 @@ void Configuration::serialize_internal(std::ostringstream* ss, ConfigNode* node)
     if (node->getType() == ConfigNode::Node) {
         *ss << std::string(node->getDepth(), '\t') << "[" << node->getName() << "]" << std::endl;
 
-        for (std::vector<ConfigNodePtr>::iterator itr = node->getChildren()->begin(); itr != node->getChildren()->end(); itr++) {
-            serialize_internal(ss, (*itr).get());
+        // sections, which have not been accessed, can be written as they were read
+        if (!copyUnparsed || !node->writeRawContent(ss)) {
+            for (std::vector<ConfigNodePtr>::iterator itr = node->getChildren()->begin(); itr != node->getChildren()->end(); itr++) {
+                serialize_internal(ss, (*itr).get(), copyUnparsed);
+            }
         }
 
         *ss << std::string(node->getDepth(), '\t') << "[!" << node->getName() << "]" << std::endl;
@@ -180,31 +654,93 @@ void Configuration::serialize_internal(std::ostringstream* ss, ConfigNode* node)
     }
 }
 
+/**
+ * Writes the configuration to the most specific file it was loaded from, if it has been changed
+ * since it was loaded or stored. With an overlay, only the keys of the overlay file and the ones
+ * changed by set() are written, so the values of the global file are not copied into it.
+ */
 void Configuration::store()
 {
-    if (this->filename.size() > 0) {
-        store(this->filename);
+    if (!this->dirty.load()) {
+        return;
+    }
+    ConfigNodePtr overlay = std::atomic_load(&this->overlayRoot);
+    if (overlay && this->overlayFilename.size() > 0) {
+        write(this->overlayFilename, overlay.get());
+        this->dirty = false;
+    } else if (this->getFilename().size() > 0) {
+        store(this->getFilename());
     }
 }
 
+/**
+ * Writes the whole configuration to the given file.
+ */
 void Configuration::store(std::string filename)
 {
-    std::ostringstream ss;
-    std::ofstream os(filename.c_str(), std::ios_base::out);
+    write(filename, this->getRoot().get());
+    if (filename == this->getFilename() || filename == this->overlayFilename) {
+        this->dirty = false;
+    }
+}
 
-    serialize_without_root(&ss, this->configRoot.get());
+/**
+ * Writes the given tree to a temporary file next to the given one and renames it afterwards,
+ * so the file either has the old or the new content, even after a crash.
+ */
+void Configuration::write(const std::string& filename, ConfigNode* root)
+{
+    std::vector<char> tmpFilename(filename.begin(), filename.end());
+    const char suffix[] = ".XXXXXX";
+    tmpFilename.insert(tmpFilename.end(), suffix, suffix + sizeof(suffix));
+
+    int fd = mkstemp(tmpFilename.data());
+    if (fd < 0) {
+        std::string errMsg = "SC-Conf: Could not create a temporary file for " + filename + ": " + strerror(errno);
+        std::cerr << errMsg << std::endl;
+        throw std::runtime_error(errMsg);
+    }
+
+    bool written;
+    {
+        FileDescriptorBuffer buffer(fd);
+        std::ostream os(&buffer);
+        serialize_without_root(&os, root, true);
+        os.flush();
+        written = os.good();
+    }
+
+    // keep the permissions of the replaced file, mkstemp creates it with 0600
+    struct stat fileStat;
+    mode_t mode = stat(filename.c_str(), &fileStat) == 0 ? (fileStat.st_mode & 07777) : 0644;
+    written = written && fchmod(fd, mode) == 0 && fsync(fd) == 0;
+    written = close(fd) == 0 && written;
+
+    if (!written || rename(tmpFilename.data(), filename.c_str()) != 0) {
+        std::string errMsg = "SC-Conf: Could not write " + filename + ": " + strerror(errno);
+        unlink(tmpFilename.data());
+        std::cerr << errMsg << std::endl;
+        throw std::runtime_error(errMsg);
+    }
 
-    os << ss.str();
+    // persist the rename itself
+    size_t separator = filename.rfind(FileSystem::PATH_SEPARATOR);
+    std::string folder = separator == std::string::npos ? "." : (separator == 0 ? "/" : filename.substr(0, separator));
+    int folderFd = open(folder.c_str(), O_RDONLY | O_DIRECTORY);
+    if (folderFd >= 0) {
+        fsync(folderFd);
+        close(folderFd);
+    }
 }
 
 std::string Configuration::serialize()
 {
     std::ostringstream ss;
-    serialize_internal(&ss, this->configRoot.get());
+    serialize_internal(&ss, this->getRoot().get());
     return ss.str();
 }
 
-void Configuration::serialize_without_root(std::ostringstream* ss, ConfigNode* node)
+void Configuration::serialize_without_root(std::ostream* ss, ConfigNode* node, bool copyUnparsed)
 {
     if (node == NULL)
         return;
@@ -213,7 +749,7 @@ void Configuration::serialize_without_root(std::ostringstream* ss, ConfigNode* n
         //*ss << string(node->getDepth(), '\t') << "[" << node->getName() << "]" << endl;
 
         for (std::vector<ConfigNodePtr>::iterator itr = node->getChildren()->begin(); itr != node->getChildren()->end(); itr++) {
-            serialize_internal(ss, (*itr).get());
+            serialize_internal(ss, (*itr).get(), copyUnparsed);
         }
 
         //*ss << string(node->getDepth(), '\t') << "[!" << node->getName() << "]" << endl;
@@ -227,19 +763,19 @@ void Configuration::serialize_without_root(std::ostringstream* ss, ConfigNode* n
     }
 }
 
-void Configuration::collect(ConfigNode* node, std::vector<std::string>* params, size_t offset, std::vector<ConfigNode*>* result)
+void Configuration::collect(ConfigNode* node, const ConfigPath& path, size_t offset, std::vector<ConfigNode*>* result)
 {
     std::vector<ConfigNodePtr>* children = node->getChildren();
-    if (offset == params->size()) {
+    if (offset == path.size()) {
         result->push_back(node);
         return;
     }
-    for (size_t i = offset; i < params->size(); i++) {
+    for (size_t i = offset; i < path.size(); i++) {
         bool found = false;
 
         for (size_t j = 0; j < children->size(); j++) {
-            if ((*children)[j]->getName().compare((*params)[i]) == 0) {
-                collect((*children)[j].get(), params, offset + 1, result);
+            if ((*children)[j]->matches(path[i])) {
+                collect((*children)[j].get(), path, offset + 1, result);
                 found = true;
             }
         }
@@ -250,22 +786,52 @@ void Configuration::collect(ConfigNode* node, std::vector<std::string>* params,
     }
 }
 
-void Configuration::collectSections(ConfigNode* node, std::vector<std::string>* params, size_t offset, std::vector<ConfigNode*>* result)
+/**
+ * Returns the node, which collect would return first, without collecting all the others.
+ * @return The first node matching the path or nullptr, if there is none.
+ */
+ConfigNode* Configuration::findFirst(ConfigNode* node, const ConfigPath& path, size_t offset)
+{
+    std::vector<ConfigNodePtr>* children = node->getChildren();
+    if (offset == path.size()) {
+        return node;
+    }
+    for (size_t i = offset; i < path.size(); i++) {
+        bool found = false;
+
+        for (size_t j = 0; j < children->size(); j++) {
+            if ((*children)[j]->matches(path[i])) {
+                ConfigNode* result = findFirst((*children)[j].get(), path, offset + 1);
+                if (result != nullptr) {
+                    return result;
+                }
+                found = true;
+            }
+        }
+
+        if (!found) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void Configuration::collectSections(ConfigNode* node, const ConfigPath& path, size_t offset, std::vector<ConfigNode*>* result)
 {
     std::vector<ConfigNodePtr>* children = node->getChildren();
 
-    if (offset == params->size()) {
+    if (offset == path.size()) {
         for (unsigned int i = 0; i < children->size(); i++) {
             result->push_back((*children)[i].get());
         }
         return;
     }
 
-    for (size_t i = offset; i < params->size(); i++) {
+    for (size_t i = offset; i < path.size(); i++) {
         bool found = false;
         for (size_t j = 0; j < children->size(); j++) {
-            if ((*children)[j]->getName().compare((*params)[i]) == 0) {
-                collectSections((*children)[j].get(), params, offset + 1, result);
+            if ((*children)[j]->matches(path[i])) {
+                collectSections((*children)[j].get(), path, offset + 1, result);
                 found = true;
             }
         }
@@ -276,20 +842,16 @@ void Configuration::collectSections(ConfigNode* node, std::vector<std::string>*
 
 /**
  * Creates a suitable error message, if the given path was not found.
- * @param params The path which does not exist.
+ * @param path The path which does not exist.
  * @return The corresponding error message.
  */
-std::string Configuration::pathNotFound(std::vector<std::string>* params)
+std::string Configuration::pathNotFound(const ConfigPath& path)
 {
     std::ostringstream os;
-    if ((params == NULL) || (params->size() == 0)) {
-        os << "Empty path not found in " << this->filename << "!" << std::endl;
+    if (path.size() == 0) {
+        os << "Empty path not found in " << this->getFilename() << "!" << std::endl;
     } else {
-        os << "Configuration: Path '" << (*params)[0];
-        for (size_t i = 1; i < params->size(); i++) {
-            os << "." << (*params)[i];
-        }
-        os << "' not found in " << this->filename << "!" << std::endl;
+        os << "Configuration: Path '" << path.toString() << "' not found in " << this->getFilename() << "!" << std::endl;
     }
     return os.str();
 }
@@ -300,21 +862,19 @@ std::string Configuration::pathNotFound(std::vector<std::string>* params)
  * @param path
  * @return A vector with the names of all sections in the given path.
  */
-std::shared_ptr<std::vector<std::string>> Configuration::getSections(const char* path, ...)
+std::shared_ptr<std::vector<std::string>> Configuration::getSections(const ConfigPath& path)
 {
-    va_list ap;
-    va_start(ap, path);
-    std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
-    va_end(ap);
-
+    ConfigProfiler::Scope profile(this->getFilename(), path);
     std::vector<ConfigNode*> nodes;
 
-    collectSections(this->configRoot.get(), params.get(), 0, &nodes);
+    ConfigNodePtr root = this->getRoot();
+    collectSections(root.get(), path, 0, &nodes);
 
     std::shared_ptr<std::vector<std::string>> result(new std::vector<std::string>());
 
     if (nodes.size() == 0) {
-        std::cerr << pathNotFound(params.get()) << std::endl;
+        profile.miss();
+        std::cerr << pathNotFound(path) << std::endl;
         throw std::exception();
     }
 
@@ -332,21 +892,19 @@ std::shared_ptr<std::vector<std::string>> Configuration::getSections(const char*
  * @param path
  * @return A vector with all keys or names of the given path.
  */
-std::shared_ptr<std::vector<std::string>> Configuration::getNames(const char* path, ...)
+std::shared_ptr<std::vector<std::string>> Configuration::getNames(const ConfigPath& path)
 {
-    va_list ap;
-    va_start(ap, path);
-    std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
-    va_end(ap);
-
+    ConfigProfiler::Scope profile(this->getFilename(), path);
     std::vector<ConfigNode*> nodes;
 
-    collectSections(this->configRoot.get(), params.get(), 0, &nodes);
+    ConfigNodePtr root = this->getRoot();
+    collectSections(root.get(), path, 0, &nodes);
 
     std::shared_ptr<std::vector<std::string>> result(new std::vector<std::string>());
 
     if (nodes.size() == 0) {
-        std::cerr << pathNotFound(params.get()) << std::endl;
+        profile.miss();
+        std::cerr << pathNotFound(path) << std::endl;
         throw std::exception();
     }
 
@@ -358,20 +916,18 @@ std::shared_ptr<std::vector<std::string>> Configuration::getNames(const char* pa
     return result;
 }
 
-std::shared_ptr<std::vector<std::string>> Configuration::tryGetSections(std::string d, const char* path, ...)
+std::shared_ptr<std::vector<std::string>> Configuration::tryGetSections(std::string d, const ConfigPath& path)
 {
-    va_list ap;
-    va_start(ap, path);
-    std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
-    va_end(ap);
-
+    ConfigProfiler::Scope profile(this->getFilename(), path);
     std::vector<ConfigNode*> nodes;
 
-    collectSections(this->configRoot.get(), params.get(), 0, &nodes);
+    ConfigNodePtr root = this->getRoot();
+    collectSections(root.get(), path, 0, &nodes);
 
     std::shared_ptr<std::vector<std::string>> result(new std::vector<std::string>());
 
     if (nodes.size() == 0) {
+        profile.miss();
         result->push_back(d);
         return result;
     }
@@ -392,20 +948,18 @@ std::shared_ptr<std::vector<std::string>> Configuration::tryGetSections(std::str
  * collected.
  * @return The names of the sections at the given path
  */
-std::shared_ptr<std::vector<std::string>> Configuration::tryGetNames(std::string d, const char* path, ...)
+std::shared_ptr<std::vector<std::string>> Configuration::tryGetNames(std::string d, const ConfigPath& path)
 {
-    va_list ap;
-    va_start(ap, path);
-    std::shared_ptr<std::vector<std::string>> params = getParams('.', path, ap);
-    va_end(ap);
-
+    ConfigProfiler::Scope profile(this->getFilename(), path);
     std::vector<ConfigNode*> nodes;
 
-    collectSections(this->configRoot.get(), params.get(), 0, &nodes);
+    ConfigNodePtr root = this->getRoot();
+    collectSections(root.get(), path, 0, &nodes);
 
     std::shared_ptr<std::vector<std::string>> result(new std::vector<std::string>());
 
     if (nodes.size() == 0) {
+        profile.miss();
         result->push_back(d);
         return result;
     }
@@ -418,6 +972,74 @@ std::shared_ptr<std::vector<std::string>> Configuration::tryGetNames(std::string
     return result;
 }
 
+/**
+ * Variant for a single path segment, which also accepts NULL for the root section.
+ */
+std::shared_ptr<std::vector<std::string>> Configuration::getSections(const char* path)
+{
+    return getSections(ConfigPath(path));
+}
+
+std::shared_ptr<std::vector<std::string>> Configuration::getSections(const char* path, ConfigPathNext next, ...)
+{
+    va_list ap;
+    va_start(ap, next);
+    ConfigPath configPath(path, next, ap);
+    va_end(ap);
+    return getSections(configPath);
+}
+
+/**
+ * Variant for a single path segment, which also accepts NULL for the root section.
+ */
+std::shared_ptr<std::vector<std::string>> Configuration::tryGetSections(std::string d, const char* path)
+{
+    return tryGetSections(d, ConfigPath(path));
+}
+
+std::shared_ptr<std::vector<std::string>> Configuration::tryGetSections(std::string d, const char* path, ConfigPathNext next, ...)
+{
+    va_list ap;
+    va_start(ap, next);
+    ConfigPath configPath(path, next, ap);
+    va_end(ap);
+    return tryGetSections(d, configPath);
+}
+
+/**
+ * Variant for a single path segment, which also accepts NULL for the root section.
+ */
+std::shared_ptr<std::vector<std::string>> Configuration::getNames(const char* path)
+{
+    return getNames(ConfigPath(path));
+}
+
+std::shared_ptr<std::vector<std::string>> Configuration::getNames(const char* path, ConfigPathNext next, ...)
+{
+    va_list ap;
+    va_start(ap, next);
+    ConfigPath configPath(path, next, ap);
+    va_end(ap);
+    return getNames(configPath);
+}
+
+/**
+ * Variant for a single path segment, which also accepts NULL for the root section.
+ */
+std::shared_ptr<std::vector<std::string>> Configuration::tryGetNames(std::string d, const char* path)
+{
+    return tryGetNames(d, ConfigPath(path));
+}
+
+std::shared_ptr<std::vector<std::string>> Configuration::tryGetNames(std::string d, const char* path, ConfigPathNext next, ...)
+{
+    va_list ap;
+    va_start(ap, next);
+    ConfigPath configPath(path, next, ap);
+    va_end(ap);
+    return tryGetNames(d, configPath);
+}
+
 /**
  * Removes the given whitespaces at the beginning of the string.
  * @param str The string which should be trimmed.
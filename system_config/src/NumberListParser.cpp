@@ -0,0 +1,66 @@
+#include "NumberListParser.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace essentials
+{
+
+size_t NumberListParser::countSeparators(const char* data, size_t length)
+{
+    size_t count = 0;
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i separator = _mm_set1_epi8(SEPERATOR);
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, separator)));
+    }
+#endif
+    for (; i < length; i++) {
+        count += data[i] == SEPERATOR;
+    }
+    return count;
+}
+
+/**
+ * Floating-point elements go through strtod & co. The list is always null-terminated
+ * and the number ends at the next separator, so no temporary string is needed.
+ */
+const char* NumberListParser::parseElement(const char* pos, float* result)
+{
+    char* end;
+    errno = 0;
+    *result = strtof(pos, &end);
+    if (errno == ERANGE) {
+        throw std::out_of_range("SC-Conf: List element out of range");
+    }
+    return end;
+}
+
+const char* NumberListParser::parseElement(const char* pos, double* result)
+{
+    char* end;
+    errno = 0;
+    *result = strtod(pos, &end);
+    if (errno == ERANGE) {
+        throw std::out_of_range("SC-Conf: List element out of range");
+    }
+    return end;
+}
+
+const char* NumberListParser::parseElement(const char* pos, long double* result)
+{
+    char* end;
+    errno = 0;
+    *result = strtold(pos, &end);
+    if (errno == ERANGE) {
+        throw std::out_of_range("SC-Conf: List element out of range");
+    }
+    return end;
+}
+} // namespace essentials
@@ -1,7 +1,9 @@
 #include "SystemConfig.h"
 
+#include "ConfigWatcher.h"
 #include "Configuration.h"
 
+#include <signal.h>
 #include <unistd.h>
 
 namespace essentials
@@ -10,17 +12,18 @@ using std::cerr;
 using std::cout;
 using std::endl;
 using std::mutex;
-using std::shared_ptr;
 using std::string;
 using std::vector;
 
 // Initialize static variables
 std::string SystemConfig::rootPath;
 std::string SystemConfig::logPath;
-std::string SystemConfig::configPath;
-std::string SystemConfig::hostname;
-std::mutex SystemConfig::configsMapMutex;
-std::map<std::string, std::shared_ptr<Configuration>> SystemConfig::configs;
+std::unique_ptr<ConfigContext> SystemConfig::defaultContext;
+std::mutex SystemConfig::watcherMutex;
+ConfigWatcher* SystemConfig::watcher = nullptr;
+std::mutex SystemConfig::callbacksMutex;
+int SystemConfig::nextCallbackId = 0;
+std::map<std::string, std::map<int, std::function<void(Configuration*)>>> SystemConfig::changeCallbacks;
 
 /**
  * The method for getting the singleton instance.
@@ -32,6 +35,16 @@ SystemConfig* SystemConfig::getInstance()
     return &instance;
 }
 
+/**
+ * The context of the own robot, which all configuration accesses of SystemConfig are forwarded to.
+ * Further contexts can be created for other agents, e.g. in simulations.
+ */
+ConfigContext* SystemConfig::getContext()
+{
+    getInstance();
+    return defaultContext.get();
+}
+
 /**
  * The private constructor of the SystemConfig singleton.
  */
@@ -52,6 +65,7 @@ SystemConfig::SystemConfig()
     // set the domain config folger (1. by env-variable 2. by <domain folder>/etc
     x = ::getenv(DOMAIN_CONFIG_FOLDER.c_str());
 
+    string configPath;
     if (x == NULL) {
         configPath = FileSystem::combinePaths(rootPath, "/etc");
     } else {
@@ -69,15 +83,24 @@ SystemConfig::SystemConfig()
     }
 
     // set the hostname (1. by env-variable 2. by gethostname)
+    string hostname;
     char* envname = ::getenv("ROBOT");
     if ((envname == NULL) || ((*envname) == 0x0)) {
         char hn[1024];
         hn[1023] = '\0';
         gethostname(hn, 1023);
-        SystemConfig::hostname = hn;
+        hostname = hn;
     } else {
         hostname = envname;
     }
+    defaultContext.reset(new ConfigContext(configPath, hostname));
+
+    // profile the configuration lookups (see ConfigProfiler)
+    x = ::getenv(CONFIG_PROFILE.c_str());
+    if (x != NULL && (*x) != 0x0) {
+        ConfigProfiler::setDumpFile(x, SIGUSR2);
+        cout << "SC: Profiling lookups into \"" << x << "\"" << endl;
+    }
 
     cout << "SC: Root:           \"" << rootPath << "\"" << endl;
     cout << "SC: ConfigRoot:     \"" << configPath << "\"" << endl;
@@ -85,58 +108,46 @@ SystemConfig::SystemConfig()
     cout << "SC: Logging Folder: \"" << logPath << "\"" << endl;
 }
 
-void SystemConfig::shutdown() {}
+SystemConfig::~SystemConfig()
+{
+    shutdown();
+}
+
+void SystemConfig::shutdown()
+{
+    disableLiveReload();
+    ConfigProfiler::shutdown();
+}
 
 /**
- * The access operator for choosing the configuration according to the given string
+ * The access operator for choosing the configuration according to the given string.
  *
  * @param s The string which determines the used configuration.
  * @return The demanded configuration.
  */
 Configuration* SystemConfig::operator[](const std::string& s)
 {
-    {
-        std::lock_guard<mutex> lock(configsMapMutex);
-
-        std::map<std::string, std::shared_ptr<Configuration>>::iterator itr = configs.find(s);
-
-        if (itr != configs.end()) {
-            return itr->second.get();
-        }
-    }
-
-    vector<string> files;
-
-    string file = s + ".conf";
-
-    // Check the host-specific config
-    string tempConfigPath = configPath;
-    tempConfigPath = FileSystem::combinePaths(tempConfigPath, hostname);
-    tempConfigPath = FileSystem::combinePaths(tempConfigPath, file);
-    files.push_back(tempConfigPath);
-
-    // Check the global config
-    tempConfigPath = configPath;
-    tempConfigPath = FileSystem::combinePaths(tempConfigPath, file);
-    files.push_back(tempConfigPath);
-
-    for (size_t i = 0; i < files.size(); i++) {
-        if (FileSystem::pathExists(files[i])) {
-            std::lock_guard<mutex> lock(configsMapMutex);
-
-            std::shared_ptr<Configuration> result = std::make_shared<Configuration>(files[i]);
-            configs[s] = result;
+    return (*defaultContext)[s];
+}
 
-            return result.get();
-        }
-    }
+/**
+ * Configurations loaded after this call only parse their top-level sections on first access.
+ * Helps processes, which read a few keys of large shared configuration files.
+ */
+void SystemConfig::setLazyLoading(bool lazy)
+{
+    getContext()->setLazyLoading(lazy);
+}
 
-    // config-file not found, print error message
-    cerr << "Configuration file " << file << " not found in either location:" << endl;
-    for (size_t i = 0; i < files.size(); i++) {
-        cerr << "- " << files[i] << endl;
-    }
-    return nullptr;
+/**
+ * Loads all configuration files of the config folder and the host-specific subfolder in parallel,
+ * instead of lazily on first access (see ConfigContext::preload).
+ * @param threads The number of threads for parsing, 0 means one per hardware thread.
+ * @return The number of loaded configurations.
+ */
+size_t SystemConfig::preload(unsigned int threads)
+{
+    return getContext()->preload(threads);
 }
 
 /**
@@ -169,7 +180,7 @@ string SystemConfig::getRootPath()
 
 string SystemConfig::getConfigPath()
 {
-    return configPath;
+    return defaultContext->getConfigPath();
 }
 
 string SystemConfig::getLogPath()
@@ -179,14 +190,14 @@ string SystemConfig::getLogPath()
 
 string SystemConfig::getHostname()
 {
-    return hostname;
+    return getContext()->getHostname();
 }
 
 void SystemConfig::setHostname(const std::string& newHostname)
 {
-    hostname = newHostname;
-    configs.clear();
-    cout << "SC: Update Hostname:       \"" << hostname << "\"" << endl;
+    getContext()->setHostname(newHostname);
+    updateWatchedFolders();
+    cout << "SC: Update Hostname:       \"" << newHostname << "\"" << endl;
 }
 
 void SystemConfig::setRootPath(string rootPath)
@@ -197,7 +208,8 @@ void SystemConfig::setRootPath(string rootPath)
 
 void SystemConfig::setConfigPath(string configPath)
 {
-    this->configPath = configPath;
+    defaultContext->setConfigPath(configPath);
+    updateWatchedFolders();
     cout << "SC: Update ConfigRoot:     \"" << configPath << "\"" << endl;
 }
 
@@ -208,11 +220,11 @@ void SystemConfig::resetHostname()
         char hn[1024];
         hn[1023] = '\0';
         gethostname(hn, 1023);
-        SystemConfig::hostname = hn;
+        getContext()->setHostname(hn);
     } else {
-        hostname = envname;
+        getContext()->setHostname(envname);
     }
-    configs.clear();
+    updateWatchedFolders();
 }
 
 string SystemConfig::robotNodeName(const string& nodeName)
@@ -231,4 +243,83 @@ string SystemConfig::getEnv(const string& var)
         return val;
     }
 }
+
+/**
+ * Starts watching the config folder and the host-specific subfolder. Every time a loaded
+ * configuration file changes, it is re-parsed in the background and published as a whole,
+ * so readers are never blocked and never see a half-built tree. Afterwards, the change
+ * callbacks registered for that configuration are called.
+ */
+void SystemConfig::enableLiveReload()
+{
+    {
+        std::lock_guard<mutex> lock(watcherMutex);
+        if (watcher != nullptr) {
+            return;
+        }
+        watcher = new ConfigWatcher(&SystemConfig::onConfigFileChanged);
+    }
+    updateWatchedFolders();
+}
+
+void SystemConfig::disableLiveReload()
+{
+    std::lock_guard<mutex> lock(watcherMutex);
+    delete watcher;
+    watcher = nullptr;
+}
+
+/**
+ * Registers a callback, which is called after the given configuration has been reloaded.
+ * @param configName The name of the configuration, e.g. "Globals".
+ * @param callback The callback, which gets the reloaded configuration.
+ * @return An id for unregistering the callback.
+ */
+int SystemConfig::registerChangeCallback(const std::string& configName, std::function<void(Configuration*)> callback)
+{
+    std::lock_guard<mutex> lock(callbacksMutex);
+    int callbackId = nextCallbackId++;
+    changeCallbacks[configName][callbackId] = callback;
+    return callbackId;
+}
+
+void SystemConfig::unregisterChangeCallback(int callbackId)
+{
+    std::lock_guard<mutex> lock(callbacksMutex);
+    for (auto& entry : changeCallbacks) {
+        entry.second.erase(callbackId);
+    }
+}
+
+void SystemConfig::updateWatchedFolders()
+{
+    std::lock_guard<mutex> lock(watcherMutex);
+    if (watcher == nullptr) {
+        return;
+    }
+    watcher->setFolders(getContext()->getFolders());
+}
+
+void SystemConfig::onConfigFileChanged(const std::string& folder, const std::string& file)
+{
+    Configuration* config = getContext()->reloadFile(folder, file);
+    if (config == nullptr) {
+        return;
+    }
+
+    string configName = file.substr(0, file.size() - string(".conf").size());
+    vector<std::function<void(Configuration*)>> callbacks;
+    {
+        std::lock_guard<mutex> lock(callbacksMutex);
+        auto itr = changeCallbacks.find(configName);
+        if (itr != changeCallbacks.end()) {
+            for (auto& entry : itr->second) {
+                callbacks.push_back(entry.second);
+            }
+        }
+    }
+    for (auto& callback : callbacks) {
+        callback(config);
+    }
+}
 }
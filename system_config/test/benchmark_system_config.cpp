@@ -0,0 +1,299 @@
+#include "ClockSource.h"
+#include "Configuration.h"
+#include "DateTime.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+// Counts the heap usage while a configuration is loaded, for the memory per node.
+// The default operator delete of libstdc++ frees with free(), so it does not need to be replaced.
+static std::atomic<bool> countAllocations(false);
+static std::atomic<size_t> allocatedBytes(0);
+
+void* operator new(size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocatedBytes += size;
+    }
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+namespace
+{
+const size_t KEYS_PER_SECTION = 16;
+
+/**
+ * A synthetic configuration with the given number of keys. The keys are spread over top-level
+ * sections, each of which is nested depth levels deep.
+ */
+struct SyntheticConfig
+{
+    SyntheticConfig(size_t keys, size_t depth)
+    {
+        std::ostringstream os;
+        size_t sections = (keys + KEYS_PER_SECTION - 1) / KEYS_PER_SECTION;
+        for (size_t s = 0; s < sections; s++) {
+            std::vector<std::string> path;
+            for (size_t d = 0; d < depth; d++) {
+                path.push_back(d == 0 ? "Section" + std::to_string(s) : "Level" + std::to_string(d));
+                os << std::string(d, '\t') << "[" << path.back() << "]\n";
+            }
+            size_t sectionKeys = std::min(KEYS_PER_SECTION, keys - s * KEYS_PER_SECTION);
+            for (size_t k = 0; k < sectionKeys; k++) {
+                os << std::string(depth, '\t') << "key" << k << " = " << (s * KEYS_PER_SECTION + k) << "\n";
+            }
+            for (size_t d = depth; d > 0; d--) {
+                os << std::string(d - 1, '\t') << "[!" << path[d - 1] << "]\n";
+            }
+            path.push_back("key" + std::to_string(s % sectionKeys));
+            this->paths.push_back(path);
+        }
+        this->text = os.str();
+        this->nodes = keys + sections * depth;
+    }
+
+    std::string text;
+    size_t nodes;
+    std::vector<std::vector<std::string>> paths; /**< One existing key per top-level section */
+};
+
+const SyntheticConfig& getConfig(size_t keys, size_t depth)
+{
+    static std::map<std::pair<size_t, size_t>, std::unique_ptr<SyntheticConfig>> configs;
+    std::unique_ptr<SyntheticConfig>& config = configs[std::make_pair(keys, depth)];
+    if (!config) {
+        config.reset(new SyntheticConfig(keys, depth));
+    }
+    return *config;
+}
+
+void load(essentials::Configuration* conf, const SyntheticConfig& config)
+{
+    conf->load("synthetic.conf", std::make_shared<std::istringstream>(config.text), false, false);
+}
+
+/**
+ * The paths of the given config, which are used round-robin by the lookup benchmarks.
+ */
+std::vector<essentials::ConfigPath> lookupPaths(const SyntheticConfig& config)
+{
+    std::vector<essentials::ConfigPath> paths;
+    for (const auto& path : config.paths) {
+        paths.emplace_back(path);
+    }
+    return paths;
+}
+} // namespace
+
+static void configSizes(benchmark::internal::Benchmark* b)
+{
+    for (int keys : {1000, 10000, 100000}) {
+        for (int depth : {1, 4}) {
+            b->Args({keys, depth});
+        }
+    }
+}
+
+static void BM_Load(benchmark::State& state)
+{
+    const SyntheticConfig& config = getConfig(state.range(0), state.range(1));
+    essentials::Configuration conf;
+    for (auto _ : state) {
+        load(&conf, config);
+    }
+    state.SetBytesProcessed(state.iterations() * config.text.size());
+
+    // the old tree is freed after the new one has been built, so measure a fresh configuration
+    allocatedBytes = 0;
+    countAllocations = true;
+    {
+        essentials::Configuration measured;
+        load(&measured, config);
+        countAllocations = false;
+    }
+    state.counters["bytesPerNode"] = static_cast<double>(allocatedBytes.load()) / config.nodes;
+}
+BENCHMARK(BM_Load)->Apply(configSizes)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadLazy(benchmark::State& state)
+{
+    const SyntheticConfig& config = getConfig(state.range(0), state.range(1));
+    essentials::ConfigPath path(config.paths[config.paths.size() / 2]);
+    essentials::Configuration conf;
+    conf.setLazyLoading(true);
+    for (auto _ : state) {
+        load(&conf, config);
+        benchmark::DoNotOptimize(conf.get<int>(path));
+    }
+    state.SetBytesProcessed(state.iterations() * config.text.size());
+}
+BENCHMARK(BM_LoadLazy)->Apply(configSizes)->Unit(benchmark::kMillisecond);
+
+static void BM_Get(benchmark::State& state)
+{
+    const SyntheticConfig& config = getConfig(state.range(0), state.range(1));
+    std::vector<essentials::ConfigPath> paths = lookupPaths(config);
+    essentials::Configuration conf;
+    load(&conf, config);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(conf.get<int>(paths[i]));
+        i = (i + 1) % paths.size();
+    }
+}
+BENCHMARK(BM_Get)->Apply(configSizes);
+
+static void BM_GetVariadic(benchmark::State& state)
+{
+    const SyntheticConfig& config = getConfig(state.range(0), 1);
+    essentials::Configuration conf;
+    load(&conf, config);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(conf.get<int>("Section0", "key0"));
+    }
+}
+BENCHMARK(BM_GetVariadic)->Arg(1000)->Arg(100000);
+
+static void BM_TryGetMiss(benchmark::State& state)
+{
+    const SyntheticConfig& config = getConfig(state.range(0), state.range(1));
+    std::vector<std::vector<std::string>> missing = config.paths;
+    for (auto& path : missing) {
+        path.back() = "missing";
+    }
+    std::vector<essentials::ConfigPath> paths;
+    for (const auto& path : missing) {
+        paths.emplace_back(path);
+    }
+    essentials::Configuration conf;
+    load(&conf, config);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(conf.tryGet<int>(-1, paths[i]));
+        i = (i + 1) % paths.size();
+    }
+}
+BENCHMARK(BM_TryGetMiss)->Apply(configSizes);
+
+static void BM_GetAll(benchmark::State& state)
+{
+    const SyntheticConfig& config = getConfig(state.range(0), state.range(1));
+    std::vector<essentials::ConfigPath> paths = lookupPaths(config);
+    essentials::Configuration conf;
+    load(&conf, config);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(conf.getAll<int>(paths[i]));
+        i = (i + 1) % paths.size();
+    }
+}
+BENCHMARK(BM_GetAll)->Apply(configSizes);
+
+static void BM_GetSections(benchmark::State& state)
+{
+    const SyntheticConfig& config = getConfig(state.range(0), state.range(1));
+    essentials::Configuration conf;
+    load(&conf, config);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(conf.getSections(essentials::ConfigPath()));
+    }
+}
+BENCHMARK(BM_GetSections)->Apply(configSizes);
+
+static void BM_Store(benchmark::State& state)
+{
+    const SyntheticConfig& config = getConfig(state.range(0), state.range(1));
+    essentials::Configuration conf;
+    load(&conf, config);
+
+    char filename[] = "/tmp/system_config_benchmarkXXXXXX";
+    int fd = mkstemp(filename);
+    if (fd < 0) {
+        state.SkipWithError("Could not create a temporary file");
+        return;
+    }
+    close(fd);
+    for (auto _ : state) {
+        conf.store(filename);
+    }
+    state.SetBytesProcessed(state.iterations() * config.text.size());
+    std::remove(filename);
+}
+BENCHMARK(BM_Store)->Apply(configSizes)->Unit(benchmark::kMillisecond);
+
+static void BM_GetTimeOfDay(benchmark::State& state)
+{
+    for (auto _ : state) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        benchmark::DoNotOptimize(tv);
+    }
+}
+BENCHMARK(BM_GetTimeOfDay);
+
+static void BM_DateTimeGetUtcNow(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(essentials::DateTime::getUtcNowC());
+    }
+}
+BENCHMARK(BM_DateTimeGetUtcNow);
+
+static void BM_ClockSource(benchmark::State& state)
+{
+    essentials::ClockSource::Clock clock = static_cast<essentials::ClockSource::Clock>(state.range(0));
+    // calibrates on first use
+    essentials::ClockSource::getTicks(clock);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(essentials::ClockSource::getTicks(clock));
+    }
+}
+BENCHMARK(BM_ClockSource)
+        ->Arg(essentials::ClockSource::REALTIME)
+        ->Arg(essentials::ClockSource::REALTIME_COARSE)
+        ->Arg(essentials::ClockSource::MONOTONIC)
+        ->Arg(essentials::ClockSource::MONOTONIC_COARSE)
+        ->Arg(essentials::ClockSource::TSC);
+
+/**
+ * Writes JSON by default, so the results can be compared before and after a change, e.g. with
+ * the compare.py script of Google Benchmark. Any --benchmark_format argument takes precedence.
+ */
+int main(int argc, char** argv)
+{
+    std::vector<char*> args(argv, argv + argc);
+    bool formatGiven = false;
+    for (int i = 1; i < argc; i++) {
+        formatGiven |= strncmp(argv[i], "--benchmark_format", strlen("--benchmark_format")) == 0;
+    }
+    char jsonFormat[] = "--benchmark_format=json";
+    if (!formatGiven) {
+        args.push_back(jsonFormat);
+    }
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -1,10 +1,21 @@
+#include "DateTime.h"
 #include "SystemConfig.h"
+#include "TestConfig.h"
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <typeinfo>
 
+#include <sys/stat.h>
+
 // Declare a test
 TEST(SystemConfigBasics, readValues)
 {
@@ -52,6 +63,417 @@ TEST(SystemConfigBasics, readValues)
     float testSectionValue2 = (*sc)["Test"]->get<float>("TestSection.TestSectionValue2", NULL);
     EXPECT_FLOAT_EQ(0.66412f, testSectionValue2);
 }
+
+TEST(SystemConfigBasics, numericLists)
+{
+    essentials::SystemConfig* sc = essentials::SystemConfig::getInstance();
+    sc->setConfigPath("./etc");
+    essentials::Configuration* conf = (*sc)["Test"];
+
+    std::vector<int> ints = conf->getList<int>("intListTestValue");
+    ASSERT_EQ(4u, ints.size());
+    EXPECT_EQ(-2, ints[1]);
+    EXPECT_EQ(2147483647, ints[3]);
+    EXPECT_THROW(conf->getList<short>("intListTestValue"), std::out_of_range);
+    EXPECT_THROW(conf->getList<unsigned int>("intListTestValue"), std::runtime_error);
+
+    std::vector<double> doubles = conf->getList<double>("doubleListTestValue", NULL);
+    ASSERT_EQ(3u, doubles.size());
+    EXPECT_DOUBLE_EQ(-1000.0, doubles[1]);
+
+    float table[3];
+    EXPECT_EQ(3u, conf->getList<float>(table, 3, "doubleListTestValue"));
+    EXPECT_FLOAT_EQ(2.0f, table[2]);
+    EXPECT_THROW(conf->getList<float>(table, 2, "doubleListTestValue"), std::runtime_error);
+    EXPECT_THROW(conf->getList<long>("stringListTestValue"), std::runtime_error);
+
+    // files with CRLF line endings
+    std::vector<int> crlf;
+    essentials::NumberListParser::parse("1,\r2 ,3\r", &crlf);
+    ASSERT_EQ(3u, crlf.size());
+    EXPECT_EQ(3, crlf[2]);
+    essentials::Configuration crlfConf("CRLF.conf", "[S]\r\n\tlist = 4, 5, 6\r\n[!S]\r\n");
+    std::vector<double> crlfDoubles = crlfConf.getList<double>("S", "list");
+    ASSERT_EQ(3u, crlfDoubles.size());
+    EXPECT_DOUBLE_EQ(6.0, crlfDoubles[2]);
+}
+
+TEST(SystemConfigBasics, lazySections)
+{
+    std::string content = "# top\nkey = 1\n[A]\n\tx = 2\n\t[B]\n\t\ty = 3\n\t[!B]\n[!A]\nbetween = 4\n[C]\n\tz = 5\n[!C]\n";
+    essentials::Configuration eager("lazy.conf", content);
+    essentials::Configuration lazy;
+    lazy.setLazyLoading(true);
+    lazy.load("lazy.conf", std::make_shared<std::istringstream>(content), false, false);
+
+    EXPECT_EQ(3, lazy.get<int>("A", "B", "y"));
+    EXPECT_EQ(4, lazy.get<int>("between"));
+    EXPECT_EQ(eager.serialize(), lazy.serialize());
+
+    essentials::Configuration eagerFile("./etc/Test.conf");
+    essentials::Configuration lazyFile;
+    lazyFile.setLazyLoading(true);
+    lazyFile.load("./etc/Test.conf");
+    EXPECT_EQ(eagerFile.serialize(), lazyFile.serialize());
+
+    // syntax errors inside a section show up on first access
+    lazy.load("lazy.conf", std::make_shared<std::istringstream>("[A]\n\t[B]\n\t[!C]\n[!A]\nkey = 1\n"), false, false);
+    EXPECT_EQ(1, lazy.get<int>("key"));
+    EXPECT_ANY_THROW(lazy.get<int>("A", "B", "x"));
+}
+
+TEST(SystemConfigBasics, variadicPaths)
+{
+    essentials::SystemConfig* sc = essentials::SystemConfig::getInstance();
+    sc->setConfigPath("./etc");
+    essentials::Configuration* conf = (*sc)["Test"];
+
+    EXPECT_EQ(221, conf->get<int>("intTestValue"));
+    EXPECT_FLOAT_EQ(0.66412f, conf->get<float>("TestSection.TestSectionValue2"));
+
+    std::string section = "TestSection";
+    EXPECT_EQ("TestSectionValue1", conf->get<std::string>(section, "TestSectionValue1"));
+    EXPECT_EQ("TestSectionValue1", conf->get<std::string>(section.c_str(), "TestSectionValue1", NULL));
+
+    static constexpr essentials::ConfigPathSegment key("TestSectionValue1");
+    EXPECT_EQ("TestSectionValue1", conf->get<std::string>(section, key));
+
+    // buffers are no literals, only their content up to the first null counts
+    char name[32];
+    strcpy(name, "intTestValue");
+    EXPECT_EQ(221, conf->get<int>(name));
+    EXPECT_EQ(221, conf->get<int>(name, NULL));
+    EXPECT_EQ(221, conf->get<int>(essentials::ConfigPathSegment(name)));
+    const char constName[32] = "intTestValue";
+    EXPECT_EQ(221, conf->get<int>(constName));
+
+    EXPECT_EQ(42, conf->tryGet<int>(42, "TestSection", "notExisting"));
+    EXPECT_EQ(2u, conf->getNames("TestSection")->size());
+    EXPECT_EQ("TestSection", (*conf->tryGetSections("NONE", NULL))[0]);
+}
+
+struct TestSection
+{
+    std::string value1;
+    float value2;
+};
+
+TEST(SystemConfigBasics, boundParams)
+{
+    essentials::Configuration conf("Bound.conf", "speed = 1.5\n[TestSection]\nTestSectionValue1 = a\nTestSectionValue2 = 2.5\n[!TestSection]\n");
+
+    essentials::ConfigParam<double> speed = conf.bind<double>("speed");
+    essentials::ConfigStruct<TestSection> section = conf.bindStruct<TestSection>(
+            {essentials::ConfigField<TestSection>("TestSectionValue1", &TestSection::value1),
+                    essentials::ConfigField<TestSection>("TestSectionValue2", &TestSection::value2)},
+            "TestSection");
+    EXPECT_DOUBLE_EQ(1.5, speed.get());
+    EXPECT_EQ("a", section.get().value1);
+    EXPECT_FLOAT_EQ(2.5f, section.get().value2);
+
+    conf.set<std::string>("3.5", "speed");
+    EXPECT_DOUBLE_EQ(3.5, speed.get());
+
+    conf.load("Bound.conf", std::make_shared<std::istringstream>("speed = 4.5\n[TestSection]\nTestSectionValue1 = b\nTestSectionValue2 = 5.5\n[!TestSection]\n"),
+            false, false);
+    EXPECT_DOUBLE_EQ(4.5, speed.get());
+    EXPECT_EQ("b", section.get().value1);
+    EXPECT_FLOAT_EQ(5.5f, section.get().value2);
+
+    // values, which cannot be converted, do not stop the other bindings
+    conf.load("Bound.conf", std::make_shared<std::istringstream>("speed = fast\n[TestSection]\nTestSectionValue1 = c\nTestSectionValue2 = 6.5\n[!TestSection]\n"),
+            false, false);
+    EXPECT_DOUBLE_EQ(4.5, speed.get());
+    EXPECT_EQ("c", section.get().value1);
+    EXPECT_FLOAT_EQ(6.5f, section.get().value2);
+    EXPECT_NO_THROW(conf.set<std::string>("x", "TestSection", "TestSectionValue2"));
+    EXPECT_NO_THROW(conf.set<std::string>("7.5", "speed"));
+    EXPECT_DOUBLE_EQ(7.5, speed.get());
+    EXPECT_FLOAT_EQ(6.5f, section.get().value2);
+
+    EXPECT_THROW(conf.bind<int>("notExisting"), std::runtime_error);
+}
+
+TEST(SystemConfigBasics, generatedSchema)
+{
+    essentials::SystemConfig* sc = essentials::SystemConfig::getInstance();
+    sc->setConfigPath("./etc");
+    system_config_test::TestConfig test = system_config_test::TestConfig::load((*sc)["Test"]);
+    EXPECT_EQ(3, test.uShortTestValue);
+    EXPECT_EQ(221, test.intTestValue);
+    EXPECT_DOUBLE_EQ(0.66234023823, test.doubleTestValue);
+    EXPECT_EQ(5u, test.stringListTestValue.size());
+    EXPECT_EQ(2147483647, test.intListTestValue[3]);
+    EXPECT_EQ("TestSectionValue1", test.TestSection.TestSectionValue1);
+    EXPECT_FLOAT_EQ(0.66412f, test.TestSection.TestSectionValue2);
+
+    // type errors and missing keys show up at load time
+    essentials::Configuration wrongType("./etc/Test.conf");
+    EXPECT_NO_THROW(system_config_test::TestConfig::load(&wrongType));
+    wrongType.set<std::string>("1.5", "intTestValue");
+    EXPECT_THROW(system_config_test::TestConfig::load(&wrongType), std::runtime_error);
+    essentials::Configuration missing("Missing.conf", "intTestValue = 1\n");
+    EXPECT_THROW(system_config_test::TestConfig::load(&missing), std::runtime_error);
+}
+
+TEST(SystemConfigBasics, concurrentLookups)
+{
+    essentials::SystemConfig* sc = essentials::SystemConfig::getInstance();
+    sc->setConfigPath("./etc");
+
+    std::vector<std::thread> threads;
+    std::vector<essentials::Configuration*> results(8, nullptr);
+    for (size_t i = 0; i < results.size(); i++) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < 1000; j++) {
+                results[i] = (*sc)["Test"];
+                EXPECT_EQ(nullptr, (*sc)["NotExistingTestConfig"]);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto result : results) {
+        EXPECT_EQ((*sc)["Test"], result);
+        EXPECT_NE(nullptr, result);
+    }
+}
+
+TEST(SystemConfigBasics, preload)
+{
+    essentials::SystemConfig* sc = essentials::SystemConfig::getInstance();
+    sc->setConfigPath("./etc");
+
+    EXPECT_EQ(1u, essentials::SystemConfig::preload(4));
+    EXPECT_NE(nullptr, (*sc)["Test"]);
+    EXPECT_EQ(1u, essentials::SystemConfig::preload());
+}
+
+TEST(SystemConfigBasics, hostOverlay)
+{
+    char tmpDir[] = "/tmp/system_config_testXXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpDir) != nullptr);
+    std::string hostDir = std::string(tmpDir) + "/" + essentials::SystemConfig::getHostname();
+    ASSERT_EQ(0, mkdir(hostDir.c_str(), 0755));
+    std::string globalFile = std::string(tmpDir) + "/Overlay.conf";
+    std::string hostFile = hostDir + "/Overlay.conf";
+    std::ofstream(globalFile) << "a = 1\n[S]\n\tb = 2\n\tc = 3\n[!S]\n";
+    std::ofstream(hostFile) << "[S]\n\tc = 4\n\td = 5\n[!S]\n[T]\n\te = 6\n[!T]\n";
+
+    essentials::SystemConfig* sc = essentials::SystemConfig::getInstance();
+    sc->setConfigPath(tmpDir);
+    essentials::Configuration* conf = (*sc)["Overlay"];
+    EXPECT_EQ(1, conf->get<int>("a"));
+    EXPECT_EQ(2, conf->get<int>("S", "b"));
+    EXPECT_EQ(4, conf->get<int>("S", "c"));
+    EXPECT_EQ(5, conf->get<int>("S", "d"));
+    EXPECT_EQ(6, conf->get<int>("T", "e"));
+    EXPECT_EQ(3u, conf->getNames("S")->size());
+    EXPECT_EQ(hostFile, conf->getOverlayFilename());
+
+    // only the keys of the host file and the changed ones are stored in the host file
+    conf->set<std::string>("7", "S", "b");
+    conf->store();
+    essentials::Configuration host(hostFile);
+    EXPECT_EQ(7, host.get<int>("S", "b"));
+    EXPECT_EQ(4, host.get<int>("S", "c"));
+    EXPECT_EQ(6, host.get<int>("T", "e"));
+    EXPECT_EQ(42, host.tryGet<int>(42, "a"));
+    EXPECT_EQ(2, essentials::Configuration(globalFile).get<int>("S", "b"));
+
+    sc->setConfigPath("./etc");
+    std::remove(hostFile.c_str());
+    std::remove(hostDir.c_str());
+    std::remove(globalFile.c_str());
+    std::remove(tmpDir);
+}
+
+TEST(SystemConfigBasics, store)
+{
+    char tmpDir[] = "/tmp/system_config_testXXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpDir) != nullptr);
+    std::string confFile = std::string(tmpDir) + "/Store.conf";
+    std::ofstream(confFile) << "a = 1\n[S]\n\tb = 2\n[!S]\n";
+
+    essentials::Configuration conf(confFile);
+    struct stat before, after;
+    ASSERT_EQ(0, stat(confFile.c_str(), &before));
+    conf.store();
+    ASSERT_EQ(0, stat(confFile.c_str(), &after));
+    EXPECT_EQ(before.st_ino, after.st_ino);
+
+    conf.set<std::string>("3", "S", "b");
+    EXPECT_TRUE(conf.isDirty());
+    conf.store();
+    EXPECT_FALSE(conf.isDirty());
+    ASSERT_EQ(0, stat(confFile.c_str(), &after));
+    EXPECT_NE(before.st_ino, after.st_ino);
+    EXPECT_EQ(before.st_mode, after.st_mode);
+
+    essentials::Configuration stored(confFile);
+    EXPECT_EQ(1, stored.get<int>("a"));
+    EXPECT_EQ(3, stored.get<int>("S", "b"));
+
+    // untouched lazy sections are copied as they are
+    essentials::Configuration lazy;
+    lazy.setLazyLoading(true);
+    lazy.load(confFile);
+    lazy.store(confFile);
+    EXPECT_EQ(stored.serialize(), essentials::Configuration(confFile).serialize());
+
+    std::remove(confFile.c_str());
+    std::remove(tmpDir);
+}
+
+TEST(SystemConfigBasics, contexts)
+{
+    char tmpDir[] = "/tmp/system_config_testXXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpDir) != nullptr);
+    std::string hostDir = std::string(tmpDir) + "/robotA";
+    ASSERT_EQ(0, mkdir(hostDir.c_str(), 0755));
+    std::string globalFile = std::string(tmpDir) + "/Shared.conf";
+    std::string hostFile = hostDir + "/Shared.conf";
+    std::ofstream(globalFile) << "a = 1\n[S]\n\tb = 2\n[!S]\n";
+    std::ofstream(hostFile) << "[S]\n\tb = 3\n[!S]\n";
+
+    essentials::ConfigContext a(tmpDir, "robotA");
+    essentials::ConfigContext b(tmpDir, "robotB");
+    essentials::ConfigContext c(tmpDir, "robotC");
+    EXPECT_EQ(3, a["Shared"]->get<int>("S", "b"));
+    EXPECT_FALSE(a["Shared"]->isShared());
+    EXPECT_EQ(2, b["Shared"]->get<int>("S", "b"));
+    EXPECT_TRUE(b["Shared"]->isShared());
+    EXPECT_TRUE(c["Shared"]->isShared());
+
+    // the first set() copies the shared tree
+    b["Shared"]->set<std::string>("4", "S", "b");
+    EXPECT_FALSE(b["Shared"]->isShared());
+    EXPECT_EQ(4, b["Shared"]->get<int>("S", "b"));
+    EXPECT_EQ(2, c["Shared"]->get<int>("S", "b"));
+    EXPECT_EQ(nullptr, c["Missing"]);
+
+    // concurrent first writes must not change the tree, which is still shared
+    essentials::ConfigContext d(tmpDir, "robotD");
+    essentials::Configuration* shared = d["Shared"];
+    std::thread writer([shared] { shared->set<std::string>("5", "S", "b"); });
+    shared->set<std::string>("6", "a");
+    writer.join();
+    EXPECT_FALSE(shared->isShared());
+    EXPECT_EQ(5, shared->get<int>("S", "b"));
+    EXPECT_EQ(6, shared->get<int>("a"));
+    EXPECT_EQ(1, c["Shared"]->get<int>("a"));
+    EXPECT_EQ(2, c["Shared"]->get<int>("S", "b"));
+
+    // entries stay where they are, while many other names are looked up
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(nullptr, d["Missing" + std::to_string(i)]);
+    }
+    EXPECT_EQ(shared, d["Shared"]);
+
+    std::remove(hostFile.c_str());
+    std::remove(hostDir.c_str());
+    std::remove(globalFile.c_str());
+    std::remove(tmpDir);
+}
+
+TEST(SystemConfigBasics, profiler)
+{
+    essentials::Configuration conf("profiled.conf", "a = 1\n[S]\n\tb = 2\n[!S]\n");
+    essentials::ConfigProfiler::reset();
+    essentials::ConfigProfiler::enable();
+    for (int i = 0; i < 10; i++) {
+        conf.get<int>("S", "b");
+    }
+    conf.tryGet<int>(0, "S", "missing");
+    EXPECT_THROW(conf.get<int>("missing"), std::runtime_error);
+    essentials::ConfigProfiler::disable();
+    conf.get<int>("a");
+
+    std::string json = essentials::ConfigProfiler::toJson();
+    EXPECT_NE(std::string::npos, json.find("\"path\": \"S.b\", \"count\": 10, \"misses\": 0"));
+    EXPECT_NE(std::string::npos, json.find("\"path\": \"S.missing\", \"count\": 1, \"misses\": 1"));
+    EXPECT_NE(std::string::npos, json.find("\"path\": \"missing\", \"count\": 1, \"misses\": 1"));
+    EXPECT_EQ(std::string::npos, json.find("\"path\": \"a\""));
+    essentials::ConfigProfiler::reset();
+
+    // lookups keep reading the file name, while reloads under other names replace it
+    essentials::ConfigProfiler::enable();
+    std::atomic<bool> done(false);
+    std::thread reader([&] {
+        while (!done) {
+            conf.tryGet<int>(0, "S", "missing");
+            EXPECT_FALSE(conf.getFilename().empty());
+        }
+    });
+    for (int i = 0; i < 200; i++) {
+        conf.load("profiled" + std::to_string(i % 3) + ".conf", std::make_shared<std::istringstream>("a = 1\n"), false, false);
+    }
+    done = true;
+    reader.join();
+    essentials::ConfigProfiler::disable();
+    EXPECT_EQ("profiled1.conf", conf.getFilename());
+    essentials::ConfigProfiler::reset();
+}
+
+TEST(SystemConfigBasics, clockSource)
+{
+    // only the first read of the TSC clock waits for its 20 ms calibration
+    auto start = std::chrono::steady_clock::now();
+    essentials::DateTime::getNow(essentials::ClockSource::MONOTONIC_COARSE);
+    EXPECT_GT(std::chrono::milliseconds(15), std::chrono::steady_clock::now() - start);
+
+    long long now = essentials::DateTime::getUtcNow().getTicks();
+    for (int clock = essentials::ClockSource::REALTIME; clock <= essentials::ClockSource::TSC; clock++) {
+        essentials::DateTime time = essentials::DateTime::getNow(static_cast<essentials::ClockSource::Clock>(clock));
+        // all clocks are converted to wall clock time, the coarse ones lag behind by a kernel tick
+        EXPECT_NEAR(now, time.getTicks(), 1000000) << "clock " << clock;
+    }
+
+    int64_t last = essentials::ClockSource::getNanos(essentials::ClockSource::TSC);
+    for (int i = 0; i < 1000; i++) {
+        int64_t next = essentials::ClockSource::getNanos(essentials::ClockSource::TSC);
+        EXPECT_LE(last, next);
+        last = next;
+    }
+}
+
+TEST(SystemConfigBasics, liveReload)
+{
+    char tmpDir[] = "/tmp/system_config_testXXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpDir) != nullptr);
+    std::string confFile = std::string(tmpDir) + "/LiveReload.conf";
+    std::ofstream(confFile) << "value = 1" << std::endl;
+
+    essentials::SystemConfig* sc = essentials::SystemConfig::getInstance();
+    sc->setConfigPath(tmpDir);
+    essentials::SystemConfig::enableLiveReload();
+    essentials::Configuration* conf = (*sc)["LiveReload"];
+    EXPECT_EQ(1, conf->get<int>("value", NULL));
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool reloaded = false;
+    int callbackId = essentials::SystemConfig::registerChangeCallback("LiveReload", [&](essentials::Configuration* changed) {
+        std::lock_guard<std::mutex> lock(mtx);
+        reloaded = (changed == conf);
+        cv.notify_all();
+    });
+    std::ofstream(confFile) << "value = 2" << std::endl;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait_for(lock, std::chrono::seconds(5), [&] { return reloaded; });
+    }
+    EXPECT_TRUE(reloaded);
+    EXPECT_EQ(2, conf->get<int>("value", NULL));
+
+    essentials::SystemConfig::unregisterChangeCallback(callbackId);
+    essentials::SystemConfig::disableLiveReload();
+    sc->setConfigPath("./etc");
+    std::remove(confFile.c_str());
+    std::remove(tmpDir);
+}
+
 // Run all the tests that were declared with TEST()
 int main(int argc, char** argv)
 {